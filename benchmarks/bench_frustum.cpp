@@ -0,0 +1,68 @@
+/**
+ * Compares ViewFrustum's batched sphere test against testing each sphere
+ * in turn, as the renderer used to.
+ */
+#include <render/ViewFrustum.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+constexpr size_t kSpheres = 16384;
+constexpr int kRepeats = 1000;
+
+template <class F>
+double timeNs(F f) {
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < kRepeats; ++r) {
+        f();
+    }
+    std::chrono::duration<double, std::nano> time =
+        std::chrono::steady_clock::now() - start;
+    return time.count() / (double(kRepeats) * kSpheres);
+}
+}
+
+int main() {
+    ViewFrustum frustum(0.1f, 500.f, glm::half_pi<float>(), 1.f);
+    frustum.update(frustum.projection());
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> position(-500.f, 500.f);
+    std::uniform_real_distribution<float> radius(0.5f, 20.f);
+
+    SphereList spheres;
+    for (size_t i = 0; i < kSpheres; ++i) {
+        spheres.add({position(random), position(random), position(random)},
+                    radius(random));
+    }
+
+    std::vector<uint64_t> mask(ViewFrustum::getMaskSize(kSpheres));
+    size_t scalarVisible = 0, batchedVisible = 0;
+
+    auto scalar = timeNs([&] {
+        scalarVisible = 0;
+        for (size_t i = 0; i < kSpheres; ++i) {
+            glm::vec3 center(spheres.x[i], spheres.y[i], spheres.z[i]);
+            scalarVisible += frustum.intersects(center, spheres.radius[i]);
+        }
+    });
+
+    auto batched = timeNs([&] {
+        frustum.intersects(spheres, mask.data());
+        batchedVisible = 0;
+        for (auto word : mask) {
+            batchedVisible += __builtin_popcountll(word);
+        }
+    });
+
+    std::cout << "Spheres:  " << kSpheres << " (" << scalarVisible
+              << " visible)\n"
+              << "Scalar:   " << scalar << " ns/sphere\n"
+              << "Batched:  " << batched << " ns/sphere\n"
+              << "Speedup:  " << scalar / batched << "x\n";
+
+    return scalarVisible == batchedVisible ? 0 : 1;
+}
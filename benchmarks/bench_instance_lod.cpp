@@ -0,0 +1,331 @@
+/**
+ * Compares choosing what to draw for each instance from its precomputed
+ * InstanceRenderRecord against working it out from the model info every
+ * frame, as ObjectRenderer::renderInstance used to, with the camera moved
+ * along a benchmark track through a generated city.
+ *
+ * Usage: bench_instance_lod [track]
+ */
+#include <data/Model.hpp>
+#include <data/ModelData.hpp>
+#include <render/InstanceRenderRecord.hpp>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+constexpr size_t kInstances = 20000;
+/// Camera positions between each pair of track points
+constexpr int kSteps = 8;
+/// Distance instances are placed from the track
+constexpr float kMargin = 400.f;
+
+struct Instance {
+    glm::vec3 position;
+    glm::quat rotation;
+    SimpleModelInfo* info;
+    Model* model;
+    Instance* lod;
+    InstanceRenderRecord record;
+};
+
+/// What was drawn, so the two paths can be checked against each other
+struct Result {
+    size_t draws = 0;
+    double checksum = 0.0;
+
+    void draw(const glm::mat4& matrix, float opacity) {
+        draws++;
+        checksum += matrix[3][0] + matrix[3][1] + opacity;
+    }
+};
+
+glm::mat4 transformOf(const Instance& instance) {
+    return glm::translate(glm::mat4(), instance.position) *
+           glm::mat4_cast(instance.rotation);
+}
+
+/// The selection ObjectRenderer::renderInstance made before records
+void selectLegacy(Instance& instance, const glm::vec3& camera, int hour,
+                  Result& result) {
+    auto modelinfo = instance.info;
+
+    if (modelinfo->timeOff < modelinfo->timeOn) {
+        if (hour >= modelinfo->timeOff && hour < modelinfo->timeOn) return;
+    } else {
+        if (hour >= modelinfo->timeOff || hour < modelinfo->timeOn) return;
+    }
+
+    auto matrixModel = transformOf(instance);
+
+    float mindist = glm::length(instance.position - camera) -
+                    instance.model->getBoundingRadius();
+    mindist *= 1.f / InstanceRenderRecord::kDrawDistanceFactor;
+
+    Model* model = nullptr;
+    ModelFrame* frame = nullptr;
+    Model* fadingModel = nullptr;
+    ModelFrame* fadingFrame = nullptr;
+    auto fadingMatrix = matrixModel;
+    float opacity = 0.f;
+    constexpr float fadeRange = InstanceRenderRecord::kFadeRange;
+
+    if (modelinfo->getNumAtomics() == 1) {
+        float objectRange = modelinfo->getLodDistance(0);
+        float overlap = (mindist - objectRange);
+        if (mindist > objectRange) {
+            if (instance.lod) {
+                float LODrange = instance.lod->info->getLodDistance(0);
+                if (mindist <= LODrange && instance.lod->model) {
+                    matrixModel = transformOf(*instance.lod);
+                    model = instance.lod->model;
+                    if (overlap < fadeRange) {
+                        fadingModel = instance.model;
+                        opacity = 1.f - (overlap / fadeRange);
+                    }
+                }
+            } else if (overlap < fadeRange) {
+                fadingModel = instance.model;
+                opacity = 1.f - (overlap / fadeRange);
+            }
+        } else if (!modelinfo->LOD) {
+            model = instance.model;
+        }
+    } else {
+        auto root = instance.model->frames[0];
+        matrixModel *= root->getTransform();
+        for (int i = 0; i < modelinfo->getNumAtomics() - 1; ++i) {
+            auto ind = (modelinfo->getNumAtomics() - 1) - i;
+            float lodDistance = modelinfo->getLodDistance(i);
+            if (mindist > lodDistance) {
+                fadingFrame = root->getChildren()[ind];
+                fadingModel = instance.model;
+                opacity = 1.f - ((mindist - lodDistance) / fadeRange);
+            } else {
+                model = instance.model;
+                frame = root->getChildren()[ind];
+            }
+        }
+    }
+
+    if (model) {
+        frame = frame ? frame : model->frames[0];
+        result.draw(matrixModel * glm::inverse(frame->getTransform()), 1.f);
+    }
+    if (fadingModel && opacity >= 0.01f) {
+        fadingFrame = fadingFrame ? fadingFrame : fadingModel->frames[0];
+        result.draw(fadingMatrix * glm::inverse(fadingFrame->getTransform()),
+                    opacity);
+    }
+}
+
+/// The selection ObjectRenderer::renderInstance makes from the record
+void selectRecord(Instance& instance, const glm::vec3& camera, int hour,
+                  Result& result) {
+    auto& record = instance.record;
+    if (!record.isShownAt(hour)) {
+        return;
+    }
+
+    auto offset = instance.position - camera;
+    auto selection = record.select(glm::dot(offset, offset));
+
+    bool fading = selection.fading >= 0 && selection.opacity >= 0.01f &&
+                  record.frames[selection.fading];
+    bool drawing = selection.draw >= 0 && record.frames[selection.draw];
+    if (!drawing && !fading) {
+        return;
+    }
+
+    auto matrixModel = transformOf(instance);
+    if (drawing) {
+        glm::mat4 matrix;
+        if (record.atomics != 1) {
+            matrix = matrixModel * record.model->frames[0]->getTransform();
+        } else if (selection.draw == 1) {
+            matrix = transformOf(*instance.lod);
+        } else {
+            matrix = matrixModel;
+        }
+        result.draw(matrix * record.inverseFrames[selection.draw], 1.f);
+    }
+    if (fading) {
+        result.draw(matrixModel * record.inverseFrames[selection.fading],
+                    selection.opacity);
+    }
+}
+
+/// Models with a root frame, and a child of it for each atomic if there's
+/// more than one
+std::unique_ptr<Model> createModel(int atomics, float radius,
+                                   std::mt19937& random) {
+    std::uniform_real_distribution<float> offset(-2.f, 2.f);
+    std::unique_ptr<Model> model(new Model);
+    auto root = new ModelFrame(0, nullptr, glm::mat3(),
+                               {offset(random), offset(random), 0.f});
+    model->frames.push_back(root);
+    for (int i = 1; atomics > 1 && i <= atomics; ++i) {
+        model->frames.push_back(new ModelFrame(
+            i, root, glm::mat3(), {offset(random), offset(random), 0.f}));
+    }
+
+    auto geometry = std::make_shared<Model::Geometry>();
+    geometry->geometryBounds.center = {0.f, 0.f, 0.f};
+    geometry->geometryBounds.radius = radius;
+    model->geometries.push_back(geometry);
+    model->recalculateMetrics();
+    return model;
+}
+
+template <class F>
+double timeNs(size_t count, F f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double, std::nano> time =
+        std::chrono::steady_clock::now() - start;
+    return time.count() / double(count);
+}
+}
+
+int main(int argc, char** argv) {
+    std::string path = argc > 1 ? argv[1] : RW_BENCHMARK_DIR "/staunton.txt";
+    std::ifstream track(path);
+    if (!track) {
+        std::cerr << "Failed to open " << path << "\n";
+        return 1;
+    }
+
+    // The same format BenchmarkState reads: the time of day, then a time,
+    // position and rotation for each point.
+    int hour = 0, minute = 0;
+    char separator;
+    track >> hour >> separator >> minute;
+    std::vector<glm::vec3> points;
+    float time;
+    glm::vec3 position;
+    glm::quat rotation;
+    while (track >> time >> position.x >> position.y >> position.z >>
+           rotation.x >> rotation.y >> rotation.z >> rotation.w) {
+        points.push_back(position);
+    }
+    if (points.size() < 2) {
+        std::cerr << "Not enough points in " << path << "\n";
+        return 1;
+    }
+
+    std::vector<glm::vec3> cameras;
+    glm::vec3 min = points[0], max = points[0];
+    for (size_t p = 0; p + 1 < points.size(); ++p) {
+        for (int s = 0; s < kSteps; ++s) {
+            cameras.push_back(
+                glm::mix(points[p], points[p + 1], s / float(kSteps)));
+        }
+        min = glm::min(min, points[p + 1]);
+        max = glm::max(max, points[p + 1]);
+    }
+
+    // A city around the track: most buildings have a LOD instance, some
+    // are only shown at night and some switch between atomics.
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> x(min.x - kMargin, max.x + kMargin);
+    std::uniform_real_distribution<float> y(min.y - kMargin, max.y + kMargin);
+    std::uniform_real_distribution<float> unit(0.f, 1.f);
+
+    std::vector<std::unique_ptr<Model>> models;
+    std::vector<std::unique_ptr<SimpleModelInfo>> infos;
+    std::vector<std::unique_ptr<Instance>> instances;
+
+    auto createInstance = [&](const glm::vec3& position, int atomics,
+                              float radius) {
+        models.push_back(createModel(atomics, radius, random));
+        infos.emplace_back(new SimpleModelInfo);
+        auto info = infos.back().get();
+        info->setNumAtomics(atomics);
+        info->setAtomic(models.back().get(), 0, models.back()->frames[0]);
+        instances.emplace_back(new Instance{
+            position, glm::angleAxis(unit(random) * 6.28f, glm::vec3(0, 0, 1)),
+            info, models.back().get(), nullptr, {}});
+        return instances.back().get();
+    };
+
+    while (instances.size() < kInstances) {
+        glm::vec3 position(x(random), y(random), 0.f);
+        float kind = unit(random);
+        float radius = 5.f + unit(random) * 30.f;
+        if (kind < 0.1f) {
+            auto instance = createInstance(position, 2 + (kind < 0.05f),
+                                           radius);
+            instance->info->setLodDistance(0, 60.f + unit(random) * 40.f);
+            instance->info->setLodDistance(1, 150.f + unit(random) * 100.f);
+        } else {
+            auto instance = createInstance(position, 1, radius);
+            instance->info->setLodDistance(0, 100.f + unit(random) * 150.f);
+            if (kind < 0.2f) {
+                instance->info->timeOn = 20;
+                instance->info->timeOff = 6;
+            }
+            if (kind > 0.4f) {
+                auto lod = createInstance(position, 1, radius * 1.2f);
+                lod->info->LOD = true;
+                lod->info->setLodDistance(0, 600.f + unit(random) * 300.f);
+                instances[instances.size() - 2]->lod = lod;
+            }
+        }
+    }
+
+    // Built at placement, so not timed
+    for (auto& instance : instances) {
+        SimpleModelInfo* lodInfo = nullptr;
+        Model* lodModel = nullptr;
+        if (instance->lod) {
+            lodInfo = instance->lod->info;
+            lodModel = instance->lod->model;
+        }
+        instance->record.build(instance->info, instance->model, lodInfo,
+                               lodModel);
+    }
+
+    auto count = instances.size() * cameras.size();
+    Result legacyResult, recordResult;
+
+    auto legacy = timeNs(count, [&] {
+        for (auto& camera : cameras) {
+            for (auto& instance : instances) {
+                selectLegacy(*instance, camera, hour, legacyResult);
+            }
+        }
+    });
+
+    auto record = timeNs(count, [&] {
+        for (auto& camera : cameras) {
+            for (auto& instance : instances) {
+                selectRecord(*instance, camera, hour, recordResult);
+            }
+        }
+    });
+
+    bool matches =
+        legacyResult.draws == recordResult.draws &&
+        std::abs(legacyResult.checksum - recordResult.checksum) <=
+            1e-5 * std::abs(legacyResult.checksum) + 1.0;
+
+    std::cout << "Track:      " << path << " (" << cameras.size()
+              << " cameras)\n"
+              << "Instances:  " << instances.size() << " ("
+              << recordResult.draws / cameras.size() << " drawn per frame)\n"
+              << "Per frame:  " << legacy << " ns/instance\n"
+              << "Records:    " << record << " ns/instance\n"
+              << "Speedup:    " << legacy / record << "x\n"
+              << "Draws match: " << (matches ? "yes" : "no") << "\n";
+
+    return matches ? 0 : 1;
+}
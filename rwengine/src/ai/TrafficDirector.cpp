@@ -35,15 +35,25 @@ std::vector<AIGraphNode*> TrafficDirector::findAvailableNodes(
     float minDist = (10.f / density) * (10.f / density);
     float halfRadius2 = std::pow(radius / 2.f, 2.f);
 
+    // Test every node against the view frustum at once
+    SphereList spheres;
+    for (auto node : available) {
+        spheres.add(node->position, 1.f);
+    }
+    std::vector<uint64_t> inView(ViewFrustum::getMaskSize(spheres.size()));
+    camera.frustum.intersects(spheres, inView.data());
+
     // Check if any of the nearby nodes are blocked by a pedestrian standing on
     // it
     // or because it's inside the view frustum
-    for (auto it = available.begin(); it != available.end();) {
+    size_t kept = 0;
+    for (size_t i = 0; i < available.size(); ++i) {
+        auto node = available[i];
         bool blocked = false;
-        float dist2 = glm::distance2(camera.position, (*it)->position);
+        float dist2 = glm::distance2(camera.position, node->position);
 
         for (auto& obj : world->pedestrianPool.objects) {
-            if (glm::distance2((*it)->position, obj.second->getPosition()) <=
+            if (glm::distance2(node->position, obj.second->getPosition()) <=
                 minDist) {
                 blocked = true;
                 break;
@@ -52,17 +62,15 @@ std::vector<AIGraphNode*> TrafficDirector::findAvailableNodes(
 
         // Check that we're not going to spawn something right where the player
         // is looking
-        if (dist2 <= halfRadius2 &&
-            camera.frustum.intersects((*it)->position, 1.f)) {
+        if (dist2 <= halfRadius2 && ViewFrustum::isVisible(inView.data(), i)) {
             blocked = true;
         }
 
-        if (blocked) {
-            it = available.erase(it);
-        } else {
-            it++;
+        if (!blocked) {
+            available[kept++] = node;
         }
     }
+    available.resize(kept);
 
     return available;
 }
@@ -7,8 +7,10 @@
 #include <array>
 #include <iostream>
 
-SoundManager::SoundManager() {
-    initializeOpenAL();
+SoundManager::SoundManager(bool openDevice) {
+    if (openDevice) {
+        initializeOpenAL();
+    }
 }
 
 SoundManager::~SoundManager() {
@@ -85,6 +87,10 @@ bool SoundManager::SoundBuffer::bufferData(SoundSource& soundSource) {
 
 bool SoundManager::loadSound(const std::string& name,
                              const std::string& fileName) {
+    if (!alContext) {
+        return false;
+    }
+
     Sound* sound = nullptr;
     auto sound_iter = sounds.find(name);
 
@@ -142,6 +148,10 @@ bool SoundManager::playBackground(const std::string& fileName) {
 
 bool SoundManager::loadMusic(const std::string& name,
                              const std::string& fileName) {
+    if (!alContext) {
+        return false;
+    }
+
     MADStream* music = nullptr;
     auto music_iter = musics.find(name);
 
@@ -12,7 +12,11 @@ class MADStream;
 
 class SoundManager {
 public:
-    SoundManager();
+    /**
+     * @param openDevice Opens the default OpenAL device, nothing is loaded
+     * or played if not
+     */
+    explicit SoundManager(bool openDevice = true);
     ~SoundManager();
 
     bool loadSound(const std::string& name, const std::string& fileName);
@@ -39,6 +39,9 @@ struct CollisionModel {
     std::string name;
     uint16_t modelid;
 
+    /// Name of the COL file the model was loaded from
+    std::string file;
+
     Sphere boundingSphere;
     Box boundingBox;
 
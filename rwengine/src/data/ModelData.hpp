@@ -134,8 +134,12 @@ public:
 
     /// @todo change with librw
     void setAtomic(Model* model, int n, ModelFrame* atomic) {
+        RW_CHECK(n >= 0 && n < 3, "Lod Index out of range");
         model_ = model;
-        atomics_[n] = atomic;
+        // Frames with an unknown LOD, such as _l3, aren't drawn
+        if (n >= 0 && n < 3) {
+            atomics_[n] = atomic;
+        }
     }
 
     /// @todo remove this
@@ -172,6 +176,9 @@ public:
     void unload() override {
         delete model_;
         model_ = nullptr;
+        for (auto& atomic : atomics_) {
+            atomic = nullptr;
+        }
     }
 
     enum {
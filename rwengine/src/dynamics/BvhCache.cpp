@@ -0,0 +1,296 @@
+#include <dynamics/BvhCache.hpp>
+
+#include <rw/defines.hpp>
+
+#include <algorithm>
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace bip = boost::interprocess;
+
+namespace {
+constexpr uint32_t kBvhCacheMagic = 0x43485642;  // "BVHC"
+constexpr uint32_t kBvhCacheVersion = 1;
+/// Bullet's in-place serialization requires this alignment
+constexpr uint32_t kBvhAlignment = 16;
+
+struct BvhCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    /// The layout of the serialized BVH depends on these
+    uint32_t bulletVersion;
+    uint32_t pointerSize;
+    uint32_t entryCount;
+    uint32_t padding;
+};
+
+struct BvhCacheEntry {
+    char name[24];
+    uint64_t hash;
+    /// Offset of the serialized BVH from the start of the file
+    uint64_t offset;
+    uint64_t size;
+};
+
+bool isValidHeader(const BvhCacheHeader& header) {
+    return header.magic == kBvhCacheMagic &&
+           header.version == kBvhCacheVersion &&
+           header.bulletVersion == BT_BULLET_VERSION &&
+           header.pointerSize == sizeof(void*);
+}
+
+std::string toLower(std::string name) {
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    return name;
+}
+
+uint64_t fnv1a(uint64_t hash, const void* data, size_t size) {
+    auto bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+}
+
+void BvhCache::AlignedFree::operator()(char* buffer) const {
+    btAlignedFree(buffer);
+}
+
+BvhCache::BvhCache(const std::string& directory) : m_directory(directory) {
+}
+
+BvhCache::~BvhCache() {
+}
+
+uint64_t BvhCache::hashCollision(const CollisionModel* model) {
+    uint64_t hash = 14695981039346656037ull;
+    for (auto& vertex : model->vertices) {
+        hash = fnv1a(hash, &vertex, sizeof(vertex));
+    }
+    for (auto& face : model->faces) {
+        hash = fnv1a(hash, face.tri, sizeof(face.tri));
+    }
+    return hash;
+}
+
+std::string BvhCache::getCachePath(const std::string& colFile) const {
+    return (boost::filesystem::path(m_directory) / (toLower(colFile) + ".bvh"))
+        .string();
+}
+
+BvhCache::CacheFile& BvhCache::getFile(const std::string& colFile) {
+    auto name = toLower(colFile);
+    auto it = m_files.find(name);
+    if (it != m_files.end()) {
+        return it->second;
+    }
+
+    auto& file = m_files[name];
+    auto path = getCachePath(colFile);
+    if (!boost::filesystem::exists(path)) {
+        return file;
+    }
+
+    try {
+        // Deserializing fixes up the BVHs in place, so map them privately
+        bip::file_mapping mapping(path.c_str(), bip::read_only);
+        file.mapping =
+            std::make_shared<bip::mapped_region>(mapping, bip::copy_on_write);
+    } catch (bip::interprocess_exception& ex) {
+        RW_ERROR("Failed to map BVH cache " << path << ": " << ex.what());
+        return file;
+    }
+
+    auto base = static_cast<char*>(file.mapping->get_address());
+    auto size = file.mapping->get_size();
+
+    BvhCacheHeader header;
+    if (size < sizeof(header)) {
+        return file;
+    }
+    std::memcpy(&header, base, sizeof(header));
+    if (!isValidHeader(header) ||
+        sizeof(header) + header.entryCount * sizeof(BvhCacheEntry) > size) {
+        return file;
+    }
+
+    auto entries = base + sizeof(header);
+    for (size_t i = 0; i < header.entryCount; ++i) {
+        BvhCacheEntry entry;
+        std::memcpy(&entry, entries + i * sizeof(entry), sizeof(entry));
+        if (entry.offset % kBvhAlignment != 0 || entry.offset > size ||
+            entry.size > size - entry.offset) {
+            continue;
+        }
+        entry.name[sizeof(entry.name) - 1] = '\0';
+        file.entries[toLower(entry.name)] = i;
+    }
+
+    return file;
+}
+
+btOptimizedBvh* BvhCache::findBvh(const CollisionModel* model) {
+    auto& file = getFile(model->file);
+    auto name = toLower(model->name);
+
+    auto loaded = file.loaded.find(name);
+    if (loaded != file.loaded.end()) {
+        return loaded->second;
+    }
+
+    auto index = file.entries.find(name);
+    if (index == file.entries.end()) {
+        return nullptr;
+    }
+
+    auto base = static_cast<char*>(file.mapping->get_address());
+    BvhCacheEntry entry;
+    std::memcpy(&entry,
+                base + sizeof(BvhCacheHeader) + index->second * sizeof(entry),
+                sizeof(entry));
+    if (entry.hash != hashCollision(model)) {
+        return nullptr;
+    }
+
+    auto bvh = btOptimizedBvh::deSerializeInPlace(base + entry.offset,
+                                                  entry.size, false);
+    // The entry can't be deserialized again, even if this failed
+    file.entries.erase(index);
+    if (bvh) {
+        file.loaded[name] = bvh;
+    }
+    return bvh;
+}
+
+void BvhCache::addBvh(const CollisionModel* model, const btOptimizedBvh* bvh) {
+    PendingBvh pending;
+    pending.hash = hashCollision(model);
+    pending.size = bvh->calculateSerializeBufferSize();
+    pending.data = AlignedBuffer(
+        static_cast<char*>(btAlignedAlloc(pending.size, kBvhAlignment)));
+
+    if (!bvh->serializeInPlace(pending.data.get(), pending.size, false)) {
+        return;
+    }
+
+    getFile(model->file).pending[toLower(model->name)] = std::move(pending);
+}
+
+void BvhCache::save() {
+    boost::system::error_code ec;
+    boost::filesystem::create_directories(m_directory, ec);
+
+    for (auto& it : m_files) {
+        auto& file = it.second;
+        if (file.pending.empty()) {
+            continue;
+        }
+
+        auto path = getCachePath(it.first);
+
+        // Keep the existing entries that haven't been replaced. They are
+        // read from the file, since the mapped copies may be deserialized.
+        struct Blob {
+            std::string name;
+            uint64_t hash;
+            std::vector<char> data;
+        };
+        std::vector<Blob> existing;
+        {
+            std::ifstream old(path, std::ios_base::binary);
+            BvhCacheHeader header;
+            if (old.read(reinterpret_cast<char*>(&header), sizeof(header)) &&
+                isValidHeader(header)) {
+                std::vector<BvhCacheEntry> entries(header.entryCount);
+                old.read(reinterpret_cast<char*>(entries.data()),
+                         entries.size() * sizeof(BvhCacheEntry));
+                for (auto& entry : entries) {
+                    entry.name[sizeof(entry.name) - 1] = '\0';
+                    auto name = toLower(entry.name);
+                    if (!old || file.pending.count(name)) {
+                        continue;
+                    }
+                    Blob blob{name, entry.hash,
+                              std::vector<char>(entry.size)};
+                    old.seekg(entry.offset);
+                    if (old.read(blob.data.data(), entry.size)) {
+                        existing.push_back(std::move(blob));
+                    }
+                    old.clear();
+                }
+            }
+        }
+
+        std::vector<BvhCacheEntry> entries;
+        std::vector<std::pair<const char*, size_t>> blobs;
+        for (auto& blob : existing) {
+            BvhCacheEntry entry{};
+            std::strncpy(entry.name, blob.name.c_str(), sizeof(entry.name) - 1);
+            entry.hash = blob.hash;
+            entry.size = blob.data.size();
+            entries.push_back(entry);
+            blobs.emplace_back(blob.data.data(), blob.data.size());
+        }
+        for (auto& pending : file.pending) {
+            BvhCacheEntry entry{};
+            std::strncpy(entry.name, pending.first.c_str(),
+                         sizeof(entry.name) - 1);
+            entry.hash = pending.second.hash;
+            entry.size = pending.second.size;
+            entries.push_back(entry);
+            blobs.emplace_back(pending.second.data.get(), pending.second.size);
+        }
+
+        uint64_t offset =
+            sizeof(BvhCacheHeader) + entries.size() * sizeof(BvhCacheEntry);
+        for (auto& entry : entries) {
+            offset = (offset + kBvhAlignment - 1) / kBvhAlignment *
+                     kBvhAlignment;
+            entry.offset = offset;
+            offset += entry.size;
+        }
+
+        BvhCacheHeader header{kBvhCacheMagic,
+                              kBvhCacheVersion,
+                              BT_BULLET_VERSION,
+                              sizeof(void*),
+                              static_cast<uint32_t>(entries.size()),
+                              0};
+
+        // Write a new file and move it over the old one, which may be mapped
+        auto tempPath = path + ".tmp";
+        {
+            std::ofstream out(tempPath, std::ios_base::binary);
+            out.write(reinterpret_cast<char*>(&header), sizeof(header));
+            out.write(reinterpret_cast<char*>(entries.data()),
+                      entries.size() * sizeof(BvhCacheEntry));
+            for (size_t i = 0; i < entries.size(); ++i) {
+                auto position = static_cast<uint64_t>(out.tellp());
+                std::vector<char> padding(entries[i].offset - position, 0);
+                out.write(padding.data(), padding.size());
+                out.write(blobs[i].first, blobs[i].second);
+            }
+            if (!out) {
+                RW_ERROR("Failed to write BVH cache " << tempPath);
+                continue;
+            }
+        }
+
+        boost::filesystem::rename(tempPath, path, ec);
+        if (ec) {
+            RW_ERROR("Failed to replace BVH cache " << path << ": "
+                                                    << ec.message());
+            boost::filesystem::remove(tempPath, ec);
+            continue;
+        }
+
+        file.pending.clear();
+    }
+}
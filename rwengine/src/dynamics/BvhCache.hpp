@@ -0,0 +1,81 @@
+#ifndef RWENGINE_BVHCACHE_HPP
+#define RWENGINE_BVHCACHE_HPP
+#include <BulletCollision/CollisionShapes/btOptimizedBvh.h>
+#include <data/CollisionModel.hpp>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace boost {
+namespace interprocess {
+class mapped_region;
+}
+}
+
+/**
+ * @brief Stores the BVHs of collision meshes on disk so they aren't rebuilt
+ *
+ * There is a cache file for each COL file, containing the quantized BVH of
+ * each of its models in Bullet's in-place serialization format. Entries are
+ * keyed by the model name and a hash of its vertices and faces, so a
+ * changed model is simply rebuilt.
+ *
+ * Cache files are mapped when first used, and BVHs are used straight from
+ * the mapping.
+ */
+class BvhCache {
+public:
+    BvhCache(const std::string& directory);
+
+    ~BvhCache();
+
+    /**
+     * @return The cached BVH for the model, or nullptr. The cache owns the
+     * BVH, it must outlive any shape using it.
+     */
+    btOptimizedBvh* findBvh(const CollisionModel* model);
+
+    /**
+     * Adds a newly built BVH to be written by save()
+     */
+    void addBvh(const CollisionModel* model, const btOptimizedBvh* bvh);
+
+    /**
+     * Writes the cache files that have had BVHs added
+     */
+    void save();
+
+    static uint64_t hashCollision(const CollisionModel* model);
+
+private:
+    struct AlignedFree {
+        void operator()(char* buffer) const;
+    };
+    using AlignedBuffer = std::unique_ptr<char, AlignedFree>;
+
+    struct PendingBvh {
+        uint64_t hash;
+        uint32_t size;
+        AlignedBuffer data;
+    };
+
+    struct CacheFile {
+        std::shared_ptr<boost::interprocess::mapped_region> mapping;
+        /// Index of the entries in the mapping, by lower case model name
+        std::map<std::string, size_t> entries;
+        /// BVHs that have been deserialized from the mapping
+        std::map<std::string, btOptimizedBvh*> loaded;
+        /// BVHs waiting to be written
+        std::map<std::string, PendingBvh> pending;
+    };
+
+    std::string m_directory;
+    std::unordered_map<std::string, CacheFile> m_files;
+
+    std::string getCachePath(const std::string& colFile) const;
+    CacheFile& getFile(const std::string& colFile);
+};
+
+#endif
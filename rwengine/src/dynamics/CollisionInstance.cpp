@@ -36,15 +36,8 @@ CollisionInstance::~CollisionInstance() {
         // Remove body from existance.
         object->engine->dynamicsWorld->removeRigidBody(m_body);
 
-        for (btCollisionShape* shape : m_shapes) {
-            delete shape;
-        }
-
         delete m_body;
     }
-    if (m_vertArray) {
-        delete m_vertArray;
-    }
     if (m_motionState) {
         delete m_motionState;
     }
@@ -54,66 +47,14 @@ bool CollisionInstance::createPhysicsBody(GameObject* object,
                                           CollisionModel* collision,
                                           DynamicObjectData* dynamics,
                                           VehicleHandlingInfo* handling) {
-    btCompoundShape* cmpShape = new btCompoundShape;
+    // The shapes are shared by every object using this collision model
+    m_shape = object->engine->data->collisionShapes.getShape(collision);
+    btCompoundShape* cmpShape = m_shape->getShape();
 
     m_motionState = new GameObjectMotionState(object);
-    m_shapes.push_back(cmpShape);
 
     btRigidBody::btRigidBodyConstructionInfo info(0.f, m_motionState, cmpShape);
 
-    float colMin = std::numeric_limits<float>::max(),
-          colMax = std::numeric_limits<float>::lowest();
-
-    btTransform t;
-    t.setIdentity();
-
-    // Boxes
-    for (size_t i = 0; i < collision->boxes.size(); ++i) {
-        auto& box = collision->boxes[i];
-        auto size = (box.max - box.min) / 2.f;
-        auto mid = (box.min + box.max) / 2.f;
-        btCollisionShape* bshape =
-            new btBoxShape(btVector3(size.x, size.y, size.z));
-        t.setOrigin(btVector3(mid.x, mid.y, mid.z));
-        cmpShape->addChildShape(t, bshape);
-
-        colMin = std::min(colMin, mid.z - size.z);
-        colMax = std::max(colMax, mid.z + size.z);
-
-        m_shapes.push_back(bshape);
-    }
-
-    // Spheres
-    for (size_t i = 0; i < collision->spheres.size(); ++i) {
-        auto& sphere = collision->spheres[i];
-        btCollisionShape* sshape = new btSphereShape(sphere.radius);
-        t.setOrigin(
-            btVector3(sphere.center.x, sphere.center.y, sphere.center.z));
-        cmpShape->addChildShape(t, sshape);
-
-        colMin = std::min(colMin, sphere.center.z - sphere.radius);
-        colMax = std::max(colMax, sphere.center.z + sphere.radius);
-
-        m_shapes.push_back(sshape);
-    }
-
-    t.setIdentity();
-    auto& verts = collision->vertices;
-    auto& faces = collision->faces;
-    if (!verts.empty() && !faces.empty()) {
-        m_vertArray = new btTriangleIndexVertexArray(
-            faces.size(), (int*)faces.data(), sizeof(CollisionModel::Triangle),
-            verts.size(), (float*)verts.data(), sizeof(glm::vec3));
-        btBvhTriangleMeshShape* trishape =
-            new btBvhTriangleMeshShape(m_vertArray, false);
-        trishape->setMargin(0.05f);
-        cmpShape->addChildShape(t, trishape);
-
-        m_shapes.push_back(trishape);
-    }
-
-    m_collisionHeight = colMax - colMin;
-
     if (dynamics) {
         if (dynamics->uprootForce > 0.f) {
             info.m_mass = 0.f;
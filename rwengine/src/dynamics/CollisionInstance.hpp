@@ -2,6 +2,8 @@
 #define RWENGINE_COLLISIONINSTANCE_HPP
 #include <btBulletDynamicsCommon.h>
 #include <data/CollisionModel.hpp>
+#include <dynamics/CollisionShape.hpp>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -14,11 +16,7 @@ struct VehicleHandlingInfo;
  */
 class CollisionInstance {
 public:
-    CollisionInstance()
-        : m_body(nullptr)
-        , m_vertArray(nullptr)
-        , m_motionState(nullptr)
-        , m_collisionHeight(0.f) {
+    CollisionInstance() : m_body(nullptr), m_motionState(nullptr) {
     }
 
     ~CollisionInstance();
@@ -32,18 +30,15 @@ public:
     }
 
     float getBoundingHeight() const {
-        return m_collisionHeight;
+        return m_shape ? m_shape->getBoundingHeight() : 0.f;
     }
 
     void changeMass(float newMass);
 
 private:
     btRigidBody* m_body;
-    std::vector<btCollisionShape*> m_shapes;
-    btTriangleIndexVertexArray* m_vertArray;
+    std::shared_ptr<CollisionShape> m_shape;
     btMotionState* m_motionState;
-
-    float m_collisionHeight;
 };
 
 #endif
@@ -0,0 +1,105 @@
+#include <dynamics/CollisionShape.hpp>
+
+#include <algorithm>
+#include <limits>
+
+CollisionShape::CollisionShape(CollisionModel* collision, BvhCache* cache)
+    : m_compound(new btCompoundShape), m_vertArray(nullptr) {
+    float colMin = std::numeric_limits<float>::max(),
+          colMax = std::numeric_limits<float>::lowest();
+
+    btTransform t;
+    t.setIdentity();
+
+    // Boxes
+    for (size_t i = 0; i < collision->boxes.size(); ++i) {
+        auto& box = collision->boxes[i];
+        auto size = (box.max - box.min) / 2.f;
+        auto mid = (box.min + box.max) / 2.f;
+        btCollisionShape* bshape =
+            new btBoxShape(btVector3(size.x, size.y, size.z));
+        t.setOrigin(btVector3(mid.x, mid.y, mid.z));
+        m_compound->addChildShape(t, bshape);
+
+        colMin = std::min(colMin, mid.z - size.z);
+        colMax = std::max(colMax, mid.z + size.z);
+
+        m_shapes.push_back(bshape);
+    }
+
+    // Spheres
+    for (size_t i = 0; i < collision->spheres.size(); ++i) {
+        auto& sphere = collision->spheres[i];
+        btCollisionShape* sshape = new btSphereShape(sphere.radius);
+        t.setOrigin(
+            btVector3(sphere.center.x, sphere.center.y, sphere.center.z));
+        m_compound->addChildShape(t, sshape);
+
+        colMin = std::min(colMin, sphere.center.z - sphere.radius);
+        colMax = std::max(colMax, sphere.center.z + sphere.radius);
+
+        m_shapes.push_back(sshape);
+    }
+
+    t.setIdentity();
+    auto& verts = collision->vertices;
+    auto& faces = collision->faces;
+    if (!verts.empty() && !faces.empty()) {
+        m_vertArray = new btTriangleIndexVertexArray(
+            faces.size(), (int*)faces.data(), sizeof(CollisionModel::Triangle),
+            verts.size(), (float*)verts.data(), sizeof(glm::vec3));
+        auto bvh = cache ? cache->findBvh(collision) : nullptr;
+
+        btBvhTriangleMeshShape* trishape =
+            new btBvhTriangleMeshShape(m_vertArray, true, bvh == nullptr);
+        if (bvh) {
+            trishape->setOptimizedBvh(bvh);
+        } else if (cache) {
+            cache->addBvh(collision, trishape->getOptimizedBvh());
+        }
+        trishape->setMargin(0.05f);
+        m_compound->addChildShape(t, trishape);
+
+        m_shapes.push_back(trishape);
+    }
+
+    m_collisionHeight = colMax - colMin;
+}
+
+CollisionShape::~CollisionShape() {
+    delete m_compound;
+    for (btCollisionShape* shape : m_shapes) {
+        delete shape;
+    }
+    delete m_vertArray;
+}
+
+std::shared_ptr<CollisionShape> CollisionShapeCache::getShape(
+    CollisionModel* collision) {
+    auto& cached = m_shapes[collision];
+
+    auto shape = cached.lock();
+    if (!shape) {
+        shape = std::make_shared<CollisionShape>(collision, m_bvhCache.get());
+        cached = shape;
+    }
+
+    return shape;
+}
+
+size_t CollisionShapeCache::getShapeCount() const {
+    return std::count_if(m_shapes.begin(), m_shapes.end(),
+                         [](const decltype(m_shapes)::value_type& s) {
+                             return !s.second.expired();
+                         });
+}
+
+void CollisionShapeCache::setBvhCacheDirectory(const std::string& directory) {
+    m_bvhCache.reset(new BvhCache(directory));
+}
+
+void CollisionShapeCache::saveBvhCache() {
+    if (m_bvhCache) {
+        m_bvhCache->save();
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef RWENGINE_COLLISIONSHAPE_HPP
+#define RWENGINE_COLLISIONSHAPE_HPP
+#include <btBulletDynamicsCommon.h>
+#include <data/CollisionModel.hpp>
+#include <dynamics/BvhCache.hpp>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief CollisionShape stores the bullet shapes built from a CollisionModel
+ *
+ * The shapes don't depend on the object, so a single CollisionShape is
+ * shared by every body using the same CollisionModel.
+ */
+class CollisionShape {
+public:
+    /**
+     * @param collision The model to build the shapes from
+     * @param cache If set, the triangle mesh BVH is taken from or added to
+     * this cache instead of always being built.
+     */
+    CollisionShape(CollisionModel* collision, BvhCache* cache = nullptr);
+
+    ~CollisionShape();
+
+    CollisionShape(const CollisionShape&) = delete;
+    CollisionShape& operator=(const CollisionShape&) = delete;
+
+    btCompoundShape* getShape() const {
+        return m_compound;
+    }
+
+    float getBoundingHeight() const {
+        return m_collisionHeight;
+    }
+
+private:
+    btCompoundShape* m_compound;
+    std::vector<btCollisionShape*> m_shapes;
+    btTriangleIndexVertexArray* m_vertArray;
+
+    float m_collisionHeight;
+};
+
+/**
+ * @brief Builds CollisionShapes on demand and shares them between bodies
+ *
+ * Shapes are destroyed once the last body using them is gone, and rebuilt
+ * the next time they're needed.
+ */
+class CollisionShapeCache {
+public:
+    std::shared_ptr<CollisionShape> getShape(CollisionModel* collision);
+
+    /**
+     * Enables the on disk BVH cache, stored in directory
+     */
+    void setBvhCacheDirectory(const std::string& directory);
+
+    /**
+     * Writes any BVHs that were built since the cache was loaded
+     */
+    void saveBvhCache();
+
+    /**
+     * Returns the number of shapes that are currently in use
+     */
+    size_t getShapeCount() const;
+
+private:
+    std::unordered_map<CollisionModel*, std::weak_ptr<CollisionShape>>
+        m_shapes;
+
+    /// Shapes use the cached BVHs in place, they must not outlive this
+    std::unique_ptr<BvhCache> m_bvhCache;
+};
+
+#endif
@@ -16,10 +16,11 @@
 #include <platform/FileIndex.hpp>
 
 #include <algorithm>
-#include <boost/algorithm/string/predicate.hpp>
+#include <exception>
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <vector>
 
 GameData::GameData(Logger* log, WorkContext* work, const std::string& path)
     : datpath(path), logger(log), workContext(work), engine(nullptr) {
@@ -54,6 +55,50 @@ void GameData::load() {
     loadIFP("ped.ifp");
 }
 
+namespace {
+/// A file listed by a level file
+struct LevelFileEntry {
+    enum Type { IDE, COL, IPL, TXD, ModelFile };
+
+    Type type;
+    std::string path;
+
+    /// Filled in by read(), so entries can be read in parallel
+    bool parsed = false;
+    LoaderIDE ide;
+    LoaderCOL col;
+    FileHandle file;
+    std::string error;
+
+    LevelFileEntry(Type type, const std::string& path)
+        : type(type), path(path) {
+    }
+
+    void read(FileIndex& index) {
+        try {
+            switch (type) {
+                case IDE:
+                    parsed = ide.load(index.findFilePath(path).string());
+                    break;
+                case COL:
+                    parsed = col.load(index.findFilePath(path).string());
+                    break;
+                case TXD:
+                    file = index.openFile(path);
+                    break;
+                case ModelFile:
+                    file = index.openFilePath(path);
+                    break;
+                default:
+                    break;
+            }
+        } catch (std::exception& e) {
+            error = e.what();
+        }
+    }
+};
+}
+
 void GameData::loadLevelFile(const std::string& path) {
     auto datpath = index.findFilePath(path);
     std::ifstream datfile(datpath.string());
@@ -63,6 +108,7 @@ void GameData::loadLevelFile(const std::string& path) {
         return;
     }
 
+    std::vector<LevelFileEntry> entries;
     for (std::string line, cmd; std::getline(datfile, line);) {
         if (line.size() == 0 || line[0] == '#') continue;
 #ifndef RW_WINDOWS
@@ -74,27 +120,77 @@ void GameData::loadLevelFile(const std::string& path) {
             cmd = line.substr(0, space);
             if (cmd == "IDE") {
                 auto path = line.substr(space + 1);
-                loadIDE(path);
+                entries.emplace_back(LevelFileEntry::IDE, path);
             } else if (cmd == "SPLASH") {
                 splash = line.substr(space + 1);
             } else if (cmd == "COLFILE") {
-                int zone = atoi(line.substr(space + 1, 1).c_str());
+                /// @todo use the zone once COL files are loaded per zone
                 auto path = line.substr(space + 3);
-                loadCOL(zone, path);
+                entries.emplace_back(LevelFileEntry::COL, path);
             } else if (cmd == "IPL") {
                 auto path = line.substr(space + 1);
-                loadIPL(path);
+                entries.emplace_back(LevelFileEntry::IPL, path);
             } else if (cmd == "TEXDICTION") {
                 auto path = line.substr(space + 1);
                 /// @todo improve TXD handling
                 auto name = index.findFilePath(path).filename().string();
                 std::transform(name.begin(), name.end(), name.begin(),
                                ::tolower);
-                loadTXD(name);
+                // As in loadTXD, claimed now so it is only read once
+                if (headless || loadedFiles.count(name)) {
+                    continue;
+                }
+                loadedFiles[name] = true;
+                entries.emplace_back(LevelFileEntry::TXD, name);
             } else if (cmd == "MODELFILE") {
                 auto path = line.substr(space + 1);
-                loadModelFile(path);
+                entries.emplace_back(LevelFileEntry::ModelFile, path);
+            }
+        }
+    }
+
+    // Reading and parsing is independent for each file
+    workContext->parallelFor(
+        entries.size(), 1, [&](size_t, size_t begin, size_t end) {
+            for (auto i = begin; i < end; ++i) {
+                entries[i].read(index);
             }
+        });
+
+    // Models are added before the COLs and DFFs listed after them refer to
+    // them, and the textures and atomics of each are added in order
+    for (auto& entry : entries) {
+        if (!entry.error.empty()) {
+            logger->error("Data", "Failed to read " + entry.path + ": " +
+                                      entry.error);
+            continue;
+        }
+
+        switch (entry.type) {
+            case LevelFileEntry::IDE:
+                if (entry.parsed) {
+                    addIDE(entry.ide);
+                } else {
+                    logger->error("Data", "Failed to load IDE " + entry.path);
+                }
+                break;
+            case LevelFileEntry::COL:
+                if (entry.parsed) {
+                    addCOL(entry.col);
+                }
+                break;
+            case LevelFileEntry::IPL:
+                loadIPL(entry.path);
+                break;
+            case LevelFileEntry::TXD:
+                if (entry.file) {
+                    TextureLoader loader;
+                    loader.loadFromMemory(entry.file, textures);
+                }
+                break;
+            case LevelFileEntry::ModelFile:
+                addModelFile(entry.path, entry.file);
+                break;
         }
     }
 }
@@ -104,20 +200,37 @@ void GameData::loadIDE(const std::string& path) {
     LoaderIDE idel;
 
     if (idel.load(systempath)) {
-        std::move(idel.objects.begin(), idel.objects.end(),
-                  std::inserter(modelinfo, modelinfo.end()));
+        addIDE(idel);
     } else {
         logger->error("Data", "Failed to load IDE " + path);
     }
 }
 
+void GameData::addIDE(LoaderIDE& ide) {
+    for (auto& object : ide.objects) {
+        auto name = object.second->name;
+        auto simple = object.second->type() == ModelDataType::SimpleInfo;
+        if (!modelinfo.insert(std::move(object)).second) {
+            continue;
+        }
+        // As before, the first model of a name is the one found
+        if (!modelNames.find(name)) {
+            modelNames.insert(name, object.first);
+        }
+        if (simple) {
+            auto ids = simpleModelNames.find(name);
+            if (ids) {
+                ids->push_back(object.first);
+            } else {
+                simpleModelNames.insert(name, {object.first});
+            }
+        }
+    }
+}
+
 uint16_t GameData::findModelObject(const std::string model) {
-    auto defit = std::find_if(modelinfo.begin(), modelinfo.end(),
-                              [&](const decltype(modelinfo)::value_type& d) {
-                                  return boost::iequals(d.second->name, model);
-                              });
-    if (defit != modelinfo.end()) return defit->first;
-    return -1;
+    auto id = modelNames.find(model);
+    return id ? *id : -1;
 }
 
 void GameData::loadCOL(const size_t zone, const std::string& name) {
@@ -128,17 +241,21 @@ void GameData::loadCOL(const size_t zone, const std::string& name) {
     auto systempath = index.findFilePath(name).string();
 
     if (col.load(systempath)) {
-        // Associate loaded collisions with models
-        for (auto& c : col.collisions) {
-            // Find by name
-            auto id = findModelObject(c->name);
-            auto model = modelinfo.find(id);
-            if (model == modelinfo.end()) {
-                logger->error("Data", "no model for collsion " + c->name);
-                continue;
-            }
-            model->second->setCollisionModel(c);
+        addCOL(col);
+    }
+}
+
+void GameData::addCOL(LoaderCOL& col) {
+    // Associate loaded collisions with models
+    for (auto& c : col.collisions) {
+        // Find by name
+        auto id = findModelObject(c->name);
+        auto model = modelinfo.find(id);
+        if (model == modelinfo.end()) {
+            logger->error("Data", "no model for collsion " + c->name);
+            continue;
         }
+        model->second->setCollisionModel(c);
     }
 }
 
@@ -295,14 +412,16 @@ void GameData::loadWater(const std::string& path) {
     }
 }
 
-void GameData::loadTXD(const std::string& name, bool async) {
-    if (loadedFiles.find(name) != loadedFiles.end()) {
+void GameData::loadTXD(const std::string& name, bool async, bool pack) {
+    // Textures are only needed to draw with
+    if (headless || loadedFiles.find(name) != loadedFiles.end()) {
         return;
     }
 
     loadedFiles[name] = true;
 
-    auto j = new LoadTextureArchiveJob(workContext, &index, textures, name);
+    auto j = new LoadTextureArchiveJob(workContext, &index, textures, name,
+                                       pack ? textureArrays.get() : nullptr);
 
     if (async) {
         workContext->queueJob(j);
@@ -314,11 +433,16 @@ void GameData::loadTXD(const std::string& name, bool async) {
 }
 
 void GameData::getNameAndLod(std::string& name, int& lod) {
+    name.resize(splitNameAndLod(name, lod));
+}
+
+size_t GameData::splitNameAndLod(const std::string& name, int& lod) {
     auto lodpos = name.rfind("_l");
-    if (lodpos != std::string::npos) {
-        lod = std::atoi(name.substr(lodpos + 1).c_str());
-        name = name.substr(0, lodpos);
+    if (lodpos == std::string::npos) {
+        return name.size();
     }
+    lod = std::atoi(name.c_str() + lodpos + 2);
+    return lodpos;
 }
 
 Model* GameData::loadClump(const std::string& name) {
@@ -327,7 +451,7 @@ Model* GameData::loadClump(const std::string& name) {
         logger->error("Data", "Failed to load model " + name);
         return nullptr;
     }
-    LoaderDFF l;
+    LoaderDFF l(!headless);
     auto m = l.loadFromMemory(file);
     if (!m) {
         logger->error("Data", "Error loading model file " + name);
@@ -337,12 +461,15 @@ Model* GameData::loadClump(const std::string& name) {
 }
 
 void GameData::loadModelFile(const std::string& name) {
-    auto file = index.openFilePath(name);
+    addModelFile(name, index.openFilePath(name));
+}
+
+void GameData::addModelFile(const std::string& name, const FileHandle& file) {
     if (!file) {
         logger->log("Data", Logger::Error, "Failed to load model file " + name);
         return;
     }
-    LoaderDFF l;
+    LoaderDFF l(!headless);
     auto m = l.loadFromMemory(file);
     if (!m) {
         logger->log("Data", Logger::Error, "Error loading model file " + name);
@@ -351,19 +478,16 @@ void GameData::loadModelFile(const std::string& name) {
 
     // Associate the frames with models.
     for (auto& frame : m->frames) {
-        /// @todo this is useful elsewhere, please move elsewhere
-        std::string name = frame->getName();
+        auto& name = frame->getName();
         int lod = 0;
-        getNameAndLod(name, lod);
-        for (auto& model : modelinfo) {
-            auto info = model.second.get();
-            if (info->type() != ModelDataType::SimpleInfo) {
-                continue;
-            }
-            if (boost::iequals(info->name, name)) {
-                auto simple = static_cast<SimpleModelInfo*>(info);
-                simple->setAtomic(m, lod, frame);
-            }
+        auto length = splitNameAndLod(name, lod);
+        auto ids = simpleModelNames.find(name.data(), length);
+        if (!ids) {
+            continue;
+        }
+        for (auto id : *ids) {
+            auto simple = static_cast<SimpleModelInfo*>(modelinfo[id].get());
+            simple->setAtomic(m, lod, frame);
         }
     }
 }
@@ -402,12 +526,16 @@ void GameData::loadModel(ModelID model) {
                                   std::to_string(model) + " [" + name + "]");
         return;
     }
-    LoaderDFF l;
+    loadModel(info, file);
+}
+
+bool GameData::loadModel(BaseModelInfo* info, const FileHandle& file) {
+    LoaderDFF l(!headless);
     auto m = l.loadFromMemory(file);
     if (!m) {
-        logger->error("Data",
-                      "Error loading model file for " + std::to_string(model));
-        return;
+        logger->error("Data", "Error loading model file for " +
+                                  std::to_string(info->id()));
+        return false;
     }
     /// @todo handle timeinfo models correctly.
     auto isSimple = info->type() == ModelDataType::SimpleInfo;
@@ -415,9 +543,8 @@ void GameData::loadModel(ModelID model) {
         auto simple = static_cast<SimpleModelInfo*>(info);
         // Associate atomics
         for (auto& frame : m->frames) {
-            auto name = frame->getName();
             int lod = 0;
-            getNameAndLod(name, lod);
+            splitNameAndLod(frame->getName(), lod);
             simple->setAtomic(m, lod, frame);
         }
     } else {
@@ -426,6 +553,7 @@ void GameData::loadModel(ModelID model) {
         clump->setModel(m);
         /// @todo how is LOD handled for clump objects?
     }
+    return true;
 }
 
 void GameData::loadIFP(const std::string& name) {
@@ -16,15 +16,20 @@ class Logger;
 #include <rw/types.hpp>
 
 #include <audio/MADStream.hpp>
+#include <dynamics/CollisionShape.hpp>
+#include <engine/StreamingManager.hpp>
+#include <gl/TextureArrays.hpp>
 #include <gl/TextureData.hpp>
 #include <platform/FileIndex.hpp>
+#include <rw/NameTable.hpp>
 
 #include <memory>
+#include <unordered_map>
 
 struct DynamicObjectData;
 struct WeaponData;
 class GameWorld;
-class TextureAtlas;
+class LoaderCOL;
 class SCMFile;
 
 /**
@@ -43,6 +48,21 @@ private:
     Logger* logger;
     WorkContext* workContext;
 
+    /// The ID of each model by name, filled in by loadIDE
+    RW::NameTable<ModelID> modelNames;
+
+    /// Every SimpleModelInfo of each name, which share a DFF's atomics
+    RW::NameTable<std::vector<ModelID>> simpleModelNames;
+
+    /// Adds the models of a parsed IDE
+    void addIDE(LoaderIDE& ide);
+
+    /// Gives the models of a parsed COL their collision
+    void addCOL(LoaderCOL& col);
+
+    /// Associates the atomics of a read DFF with models
+    void addModelFile(const std::string& name, const FileHandle& file);
+
 public:
     /**
      * ctor
@@ -53,6 +73,12 @@ public:
 
     GameWorld* engine;
 
+    /**
+     * Nothing is loaded that needs a GL context, models get no GL buffers
+     * and textures aren't loaded. Worlds don't open an audio device.
+     */
+    bool headless = false;
+
     /**
      * Returns the current platform
      */
@@ -109,19 +135,31 @@ public:
 
     /**
      * Loads model, placement, models and textures from a level file
+     *
+     * The files it lists are read and parsed in parallel, then added in
+     * the order they are listed, so the result is the same as loading
+     * them one at a time.
      */
     void loadLevelFile(const std::string& path);
 
     /**
      * Attempts to load a TXD, or does nothing if it has already been loaded
+     * @param pack Packs the textures into textureArrays, if there are any
      */
-    void loadTXD(const std::string& name, bool async = false);
+    void loadTXD(const std::string& name, bool async = false,
+                 bool pack = false);
 
     /**
      * Converts combined {name}_l{LOD} into name and lod.
      */
     static void getNameAndLod(std::string& name, int& lod);
 
+    /**
+     * Finds the LOD of a combined {name}_l{LOD} without copying it.
+     * @return The length of the name before the LOD
+     */
+    static size_t splitNameAndLod(const std::string& name, int& lod);
+
     /**
      * Loads an archived model and returns it directly
      */
@@ -137,6 +175,12 @@ public:
      */
     void loadModel(ModelID model);
 
+    /**
+     * Associates the model in an already opened DFF
+     * @return false if the file couldn't be parsed
+     */
+    bool loadModel(BaseModelInfo* info, const FileHandle& file);
+
     /**
      * Loads an IFP file containing animations
      */
@@ -157,9 +201,14 @@ public:
 
     void loadSplash(const std::string& name);
 
+    /**
+     * Doesn't modify the texture map, so it may be called from the render
+     * list workers
+     */
     TextureData::Handle findTexture(const std::string& name,
-                                    const std::string& alpha = "") {
-        return textures[{name, alpha}];
+                                    const std::string& alpha = "") const {
+        auto it = textures.find({name, alpha});
+        return it != textures.end() ? it->second : nullptr;
     }
 
     FileIndex index;
@@ -174,11 +223,6 @@ public:
      */
     std::map<std::string, std::string> iplLocations;
 
-    /**
-     * Map of loaded archives
-     */
-    std::map<std::string, LoaderIMG> archives;
-
     /**
      * Map Zones
      */
@@ -186,6 +230,10 @@ public:
 
     std::unordered_map<ModelID, std::unique_ptr<BaseModelInfo>> modelinfo;
 
+    /**
+     * @return The ID of the model named model, ignoring case, or -1 if there
+     * is none
+     */
     uint16_t findModelObject(const std::string model);
 
     template <class T>
@@ -229,9 +277,20 @@ public:
     std::map<std::pair<std::string, std::string>, TextureData::Handle> textures;
 
     /**
-     * Texture atlases.
+     * Arrays world textures are packed into, they aren't packed if null
+     */
+    std::unique_ptr<TextureArrays> textureArrays;
+
+    /**
+     * Streams the models of instances, they are loaded as they are created
+     * if null
+     */
+    std::unique_ptr<StreamingManager> streaming;
+
+    /**
+     * Bullet shapes built from the collision models
      */
-    std::vector<TextureAtlas*> atlases;
+    CollisionShapeCache collisionShapes;
 
     /**
      * Loaded Animations
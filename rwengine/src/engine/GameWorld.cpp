@@ -84,7 +84,12 @@ public:
 };
 
 GameWorld::GameWorld(Logger* log, WorkContext* work, GameData* dat)
-    : logger(log), data(dat), randomEngine(rand()), _work(work), paused(false) {
+    : logger(log)
+    , data(dat)
+    , sound(!dat->headless)
+    , randomEngine(rand())
+    , _work(work)
+    , paused(false) {
     data->engine = this;
 
     collisionConfig = std::make_unique<btDefaultCollisionConfiguration>();
@@ -115,13 +120,50 @@ bool GameWorld::placeItems(const std::string& name) {
     LoaderIPL ipll;
 
     if (ipll.load(path)) {
+        // Read the unloaded models in archive order and load them from
+        // that, so that placing them below doesn't seek all over the
+        // archive. Their TXDs are read in the background as they're placed.
+        // Streamed models are only loaded once they're needed.
+        std::vector<SimpleModelInfo*> unloaded;
+        if (!data->streaming) {
+            for (auto& inst : ipll.m_instances) {
+                auto oi = data->findModelInfo<SimpleModelInfo>(inst->id);
+                if (oi && !oi->isLoaded()) {
+                    unloaded.push_back(oi);
+                }
+            }
+        }
+        std::sort(unloaded.begin(), unloaded.end(),
+                  [](SimpleModelInfo* a, SimpleModelInfo* b) {
+                      return a->id() < b->id();
+                  });
+        unloaded.erase(std::unique(unloaded.begin(), unloaded.end()),
+                       unloaded.end());
+
+        std::vector<std::string> files;
+        for (auto oi : unloaded) {
+            files.push_back(oi->name + ".dff");
+        }
+        auto handles = data->index.openFiles(files);
+        for (size_t i = 0; i < unloaded.size(); ++i) {
+            // Missing files are reported when the instance is created
+            if (handles[i]) {
+                data->loadModel(unloaded[i], handles[i]);
+            }
+        }
+
         // Find the object.
+        std::vector<InstanceObject*> placed;
+        placed.reserve(ipll.m_instances.size());
         for (size_t i = 0; i < ipll.m_instances.size(); ++i) {
             std::shared_ptr<InstanceData> inst = ipll.m_instances[i];
-            if (!createInstance(inst->id, inst->pos, inst->rot)) {
+            auto instance = createInstance(inst->id, inst->pos, inst->rot);
+            if (!instance) {
                 logger->error("World", "No object data for instance " +
                                            std::to_string(inst->id) + " in " +
                                            path);
+            } else {
+                placed.push_back(instance);
             }
         }
 
@@ -139,6 +181,20 @@ bool GameWorld::placeItems(const std::string& name) {
             }
         }
 
+        // Work out what each new instance draws at each distance now, rather
+        // than on its first frame
+        for (auto instance : placed) {
+            instance->getRenderRecord();
+        }
+
+        // Objects with dynamic data can be knocked over, everything else
+        // stays where it was placed.
+        for (auto instance : placed) {
+            if (!instance->dynamics) {
+                staticInstances.insert(instance);
+            }
+        }
+
         return true;
     } else {
         logger->error("Data", "Failed to load IPL " + path);
@@ -153,12 +209,6 @@ InstanceObject* GameWorld::createInstance(const uint16_t id,
                                           const glm::quat& rot) {
     auto oi = data->findModelInfo<SimpleModelInfo>(id);
     if (oi) {
-        // Request loading of the model if it isn't loaded already.
-        /// @todo implment streaming properly
-        if (!oi->isLoaded()) {
-            data->loadModel(oi->id());
-        }
-
         std::string modelname = oi->name;
         std::string texturename = oi->textureslot;
 
@@ -167,8 +217,14 @@ InstanceObject* GameWorld::createInstance(const uint16_t id,
         std::transform(std::begin(texturename), std::end(texturename),
                        std::begin(texturename), tolower);
 
-        if (!texturename.empty()) {
-            data->loadTXD(texturename + ".txd", true);
+        // Without streaming, load everything as it is placed
+        if (!data->streaming) {
+            if (!oi->isLoaded()) {
+                data->loadModel(oi->id());
+            }
+            if (!texturename.empty()) {
+                data->loadTXD(texturename + ".txd", true, true);
+            }
         }
 
         // Check for dynamic data.
@@ -506,6 +562,10 @@ void GameWorld::destroyObject(GameObject* object) {
     auto& pool = getTypeObjectPool(object);
     pool.remove(object);
 
+    if (StaticInstanceTree::contains(object)) {
+        staticInstances.remove(static_cast<InstanceObject*>(object));
+    }
+
     // Remove from mission objects
     if (state) {
         auto& mO = state->missionObjects;
@@ -24,6 +24,7 @@ class PickupObject;
 
 class ViewCamera;
 #include <data/ModelData.hpp>
+#include <render/StaticInstanceTree.hpp>
 #include <render/VisualFX.hpp>
 
 struct BlipData;
@@ -245,6 +246,11 @@ public:
      */
     GameObject* getBlipTarget(const BlipData& blip) const;
 
+    /**
+     * Instances placed from IPL files that never move, for culling
+     */
+    StaticInstanceTree staticInstances;
+
     /**
      * Map of Model Names to Instances
      */
@@ -0,0 +1,366 @@
+#include <engine/StreamingManager.hpp>
+
+#include <engine/GameData.hpp>
+#include <engine/GameWorld.hpp>
+#include <objects/InstanceObject.hpp>
+#include <render/InstanceRenderRecord.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <unordered_set>
+
+namespace {
+/// Models read at once, so the nearest are always read soon
+constexpr size_t kMaxLoading = 32;
+/// Extra distance models are requested from, covering their size and the
+/// camera's movement while they load
+constexpr float kStreamMargin = 100.f;
+}
+
+class StreamingManager::ModelJob : public WorkJob {
+    StreamingManager* m_manager;
+    ModelID m_id;
+    std::string m_file;
+    FileHandle m_data;
+
+public:
+    ModelJob(StreamingManager* manager, ModelID id, const std::string& file)
+        : WorkJob(manager->m_work)
+        , m_manager(manager)
+        , m_id(id)
+        , m_file(file) {
+    }
+
+    void work() override {
+        m_data = m_manager->m_data->index.openFile(m_file);
+    }
+
+    void complete() override {
+        m_manager->completeModel(m_id, m_data);
+    }
+
+    size_t getCompleteCost() const override {
+        return m_data ? m_data->length : 0;
+    }
+};
+
+class StreamingManager::DictionaryJob : public LoadTextureArchiveJob {
+    StreamingManager* m_manager;
+    std::string m_name;
+
+public:
+    DictionaryJob(StreamingManager* manager, const std::string& name,
+                  TextureArchive& textures)
+        : LoadTextureArchiveJob(manager->m_work, &manager->m_data->index,
+                                textures, name,
+                                manager->m_data->textureArrays.get())
+        , m_manager(manager)
+        , m_name(name) {
+    }
+
+    void complete() override {
+        auto bytes = getCompleteCost();
+        LoadTextureArchiveJob::complete();
+        m_manager->completeDictionary(m_name, bytes);
+    }
+};
+
+StreamingManager::StreamingManager(GameData* data, WorkContext* work,
+                                   size_t budget)
+    : m_data(data)
+    , m_work(work)
+    , m_cancel(CancelToken::create())
+    , m_budget(budget) {
+}
+
+StreamingManager::~StreamingManager() {
+    // Loads still queued would complete into a destroyed manager
+    m_cancel->cancel();
+}
+
+StreamingManager::Asset& StreamingManager::getAsset(SimpleModelInfo* info) {
+    auto it = m_assets.find(info->id());
+    if (it != m_assets.end()) {
+        return it->second;
+    }
+
+    auto& asset = m_assets[info->id()];
+    asset.info = info;
+
+    float distance = 0.f;
+    for (int i = 0; i < std::min(info->getNumAtomics(), 3); ++i) {
+        distance = std::max(distance, info->getLodDistance(i));
+    }
+    asset.radius = distance * InstanceRenderRecord::kDrawDistanceFactor +
+                   InstanceRenderRecord::kFadeRange + kStreamMargin;
+    if (auto collision = info->getCollision()) {
+        auto& sphere = collision->boundingSphere;
+        asset.radius += glm::length(sphere.center) + sphere.radius;
+    }
+
+    if (!info->textureslot.empty()) {
+        asset.dictionary = info->textureslot + ".txd";
+        std::transform(asset.dictionary.begin(), asset.dictionary.end(),
+                       asset.dictionary.begin(), ::tolower);
+        m_dictionaries[asset.dictionary].models.push_back(info);
+    }
+
+    return asset;
+}
+
+void StreamingManager::addInstance(InstanceObject* instance) {
+    auto info = instance->getModelInfo<SimpleModelInfo>();
+    getAsset(info).instances.push_back(instance);
+    instance->setModel(info->getModel());
+}
+
+void StreamingManager::removeInstance(InstanceObject* instance) {
+    auto info = instance->getModelInfo<SimpleModelInfo>();
+    auto it = m_assets.find(info->id());
+    if (it == m_assets.end()) {
+        return;
+    }
+    auto& instances = it->second.instances;
+    instances.erase(std::remove(instances.begin(), instances.end(), instance),
+                    instances.end());
+}
+
+void StreamingManager::update(const glm::vec3& camera) {
+    ++m_frame;
+
+    std::vector<std::pair<float, Asset*>> wanted;
+    for (auto& entry : m_assets) {
+        auto& asset = entry.second;
+        float nearest2 = std::numeric_limits<float>::max();
+        for (auto instance : asset.instances) {
+            auto offset = instance->getPosition() - camera;
+            nearest2 = std::min(nearest2, glm::dot(offset, offset));
+        }
+        if (nearest2 > asset.radius * asset.radius) {
+            continue;
+        }
+
+        asset.lastUsed = m_frame;
+        if (asset.info->isLoaded()) {
+            // Loaded by GameData since the instances were added
+            auto model = asset.info->getModel();
+            if (asset.instances.front()->getModel() != model) {
+                for (auto instance : asset.instances) {
+                    instance->setModel(model);
+                }
+                updateBounds(asset);
+            }
+        } else if (!asset.loading && !asset.failed) {
+            wanted.emplace_back(nearest2, &asset);
+        }
+    }
+
+    std::sort(wanted.begin(), wanted.end(),
+              [](const std::pair<float, Asset*>& a,
+                 const std::pair<float, Asset*>& b) {
+                  return a.first < b.first;
+              });
+    for (auto& request : wanted) {
+        if (m_loading >= kMaxLoading) {
+            break;
+        }
+        requestModel(request.second->info, *request.second);
+    }
+
+    evict();
+}
+
+void StreamingManager::requestModel(SimpleModelInfo* info, Asset& asset) {
+    auto name = info->name;
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+
+    asset.loading = true;
+    m_loading++;
+
+    WorkJob* job = new ModelJob(this, info->id(), name + ".dff");
+    job->setCancelToken(m_cancel);
+
+    // Textures are only needed to draw with, as in GameData::loadTXD
+    if (!asset.dictionary.empty() && !m_data->headless) {
+        auto& dictionary = m_dictionaries[asset.dictionary];
+        if (dictionary.loading) {
+            // Another model is reading the textures, wait for them too
+            dictionary.job->then(job);
+            return;
+        }
+        if (!dictionary.loaded) {
+            if (m_data->loadedFiles.count(asset.dictionary)) {
+                // GameData loaded it, so it is never evicted
+                dictionary.loaded = true;
+            } else {
+                dictionary.loading = true;
+                m_data->loadedFiles[asset.dictionary] = true;
+
+                // Read the textures first, so the model is drawn with them
+                auto dictionaryJob =
+                    new DictionaryJob(this, asset.dictionary,
+                                      dictionary.textures);
+                dictionaryJob->setCancelToken(m_cancel);
+                dictionaryJob->then(job);
+                dictionary.job = dictionaryJob;
+                job = dictionaryJob;
+            }
+        }
+    }
+
+    m_work->queueJob(job);
+}
+
+void StreamingManager::completeModel(ModelID id, const FileHandle& file) {
+    m_loading--;
+
+    auto& asset = m_assets[id];
+    asset.loading = false;
+
+    auto info = asset.info;
+    if (!info->isLoaded()) {
+        if (file && m_data->loadModel(info, file)) {
+            asset.owned = true;
+            asset.bytes = file->length;
+            m_loadedBytes += asset.bytes;
+        } else {
+            asset.failed = true;
+        }
+    }
+
+    for (auto instance : asset.instances) {
+        instance->setModel(info->getModel());
+    }
+    if (info->isLoaded()) {
+        updateBounds(asset);
+    }
+}
+
+void StreamingManager::updateBounds(const Asset& asset) {
+    // Culling radii come from the loaded models, LOD models have nothing
+    // else to give them a size
+    if (!m_data->engine) {
+        return;
+    }
+    for (auto instance : asset.instances) {
+        m_data->engine->staticInstances.updateBounds(instance);
+    }
+}
+
+void StreamingManager::completeDictionary(const std::string& name,
+                                          size_t bytes) {
+    auto& dictionary = m_dictionaries[name];
+    dictionary.job = nullptr;
+    dictionary.loading = false;
+    dictionary.loaded = true;
+    dictionary.evictable = !m_data->textureArrays;
+    dictionary.bytes = bytes;
+    m_loadedBytes += bytes;
+
+    for (auto& texture : dictionary.textures) {
+        m_data->textures[texture.first] = texture.second;
+    }
+}
+
+void StreamingManager::evict() {
+    if (m_loadedBytes <= m_budget) {
+        return;
+    }
+
+    // Models that nothing but distant instances refer to, least recently
+    // used first
+    std::vector<Asset*> candidates;
+    for (auto& entry : m_assets) {
+        auto& asset = entry.second;
+        if (asset.owned && asset.info->isLoaded() &&
+            asset.lastUsed != m_frame &&
+            asset.info->getReferenceCount() ==
+                static_cast<int>(asset.instances.size())) {
+            candidates.push_back(&asset);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [](const Asset* a, const Asset* b) {
+                  return a->lastUsed < b->lastUsed;
+              });
+
+    std::vector<Asset*> evicted;
+    std::unordered_set<Model*> freed;
+    auto bytes = m_loadedBytes;
+    for (auto asset : candidates) {
+        if (bytes <= m_budget) {
+            break;
+        }
+        evicted.push_back(asset);
+        freed.insert(asset->info->getModel());
+        bytes -= asset->bytes;
+    }
+    if (evicted.empty()) {
+        return;
+    }
+
+    // A model reloaded later may be allocated where a freed one was, so
+    // records built from them, including by instances using them as LOD,
+    // are forgotten now
+    for (auto& entry : m_assets) {
+        for (auto instance : entry.second.instances) {
+            auto lod = instance->LODinstance;
+            if (freed.count(instance->getModel()) ||
+                (lod && freed.count(lod->getModel()))) {
+                instance->resetRenderRecord();
+            }
+        }
+    }
+
+    for (auto asset : evicted) {
+        for (auto instance : asset->instances) {
+            instance->setModel(nullptr);
+        }
+        asset->info->unload();
+        asset->owned = false;
+        m_loadedBytes -= asset->bytes;
+        asset->bytes = 0;
+        m_evicted++;
+
+        if (asset->dictionary.empty()) {
+            continue;
+        }
+        auto& dictionary = m_dictionaries[asset->dictionary];
+        bool used = std::any_of(
+            dictionary.models.begin(), dictionary.models.end(),
+            [](SimpleModelInfo* info) { return info->isLoaded(); });
+        if (dictionary.evictable && !used) {
+            evictDictionary(asset->dictionary, dictionary);
+        }
+    }
+}
+
+void StreamingManager::evictDictionary(const std::string& name,
+                                       Dictionary& dictionary) {
+    std::vector<TextureData::Handle> handles;
+    for (auto& texture : dictionary.textures) {
+        auto it = m_data->textures.find(texture.first);
+        if (it != m_data->textures.end() && it->second == texture.second) {
+            m_data->textures.erase(it);
+        }
+        if (std::find(handles.begin(), handles.end(), texture.second) ==
+            handles.end()) {
+            handles.push_back(texture.second);
+        }
+    }
+    dictionary.textures.clear();
+
+    // Textures still held by a material live on with it
+    for (auto& handle : handles) {
+        if (handle.use_count() == 1) {
+            GLuint texture = handle->getName();
+            glDeleteTextures(1, &texture);
+        }
+    }
+
+    m_data->loadedFiles.erase(name);
+    m_loadedBytes -= dictionary.bytes;
+    dictionary.bytes = 0;
+    dictionary.loaded = false;
+    dictionary.evictable = false;
+}
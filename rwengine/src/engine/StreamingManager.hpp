@@ -0,0 +1,146 @@
+#ifndef _RWENGINE_STREAMINGMANAGER_HPP_
+#define _RWENGINE_STREAMINGMANAGER_HPP_
+
+#include <data/ModelData.hpp>
+#include <glm/glm.hpp>
+#include <job/WorkContext.hpp>
+#include <loaders/LoaderTXD.hpp>
+#include <platform/FileHandle.hpp>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class GameData;
+class InstanceObject;
+
+/**
+ * @brief Loads the models and TXDs of instances as the camera nears them,
+ * and frees the least recently used to stay within a memory budget
+ *
+ * Instances register their model instead of loading it. Each update the
+ * models of instances within their draw distance of the camera, plus a
+ * margin for the time loading takes, are marked as used. Those that
+ * aren't loaded are read by the work context, nearest first, along with
+ * their TXD, then parsed on the main thread within its byte budget.
+ *
+ * Sizes are estimated from the files read. Once over budget, models are
+ * evicted oldest use first, and a TXD goes with the last of its models.
+ * Only models and TXDs loaded here are evicted, and a model only while
+ * every reference to its model info is from a registered instance, so
+ * nothing else is holding it. Models used this update are never evicted,
+ * which also keeps whatever is being drawn.
+ *
+ * TXDs packed into texture arrays are kept, since array layers can't be
+ * freed. An evicted TXD's GL textures are deleted unless a material still
+ * holds them.
+ */
+class StreamingManager {
+public:
+    /// Bytes of models and TXDs to keep loaded
+    StreamingManager(GameData* data, WorkContext* work, size_t budget);
+
+    ~StreamingManager();
+
+    /**
+     * @brief Streams the instance's model from now on, giving it the model
+     * whenever it is loaded
+     */
+    void addInstance(InstanceObject* instance);
+
+    void removeInstance(InstanceObject* instance);
+
+    /**
+     * @brief Requests the models around camera and evicts down to the
+     * budget. Loads finish when the work context completes them.
+     */
+    void update(const glm::vec3& camera);
+
+    size_t getBudget() const {
+        return m_budget;
+    }
+
+    /**
+     * @return Estimated bytes of the models and TXDs loaded here
+     */
+    size_t getLoadedBytes() const {
+        return m_loadedBytes;
+    }
+
+    /**
+     * @return The number of models requested but not yet loaded
+     */
+    size_t getLoadingCount() const {
+        return m_loading;
+    }
+
+    /**
+     * @return The number of models evicted so far
+     */
+    size_t getEvictedCount() const {
+        return m_evicted;
+    }
+
+private:
+    class ModelJob;
+    class DictionaryJob;
+
+    struct Dictionary {
+        /// The textures, also added to GameData::textures while loaded
+        TextureArchive textures;
+        /// Every model using it
+        std::vector<SimpleModelInfo*> models;
+        size_t bytes = 0;
+        /// The job reading it, which later models wait on too
+        WorkJob* job = nullptr;
+        bool loading = false;
+        bool loaded = false;
+        /// Loaded here and not packed
+        bool evictable = false;
+    };
+
+    struct Asset {
+        SimpleModelInfo* info = nullptr;
+        std::vector<InstanceObject*> instances;
+        /// Distance from an instance within which the model is needed
+        float radius = 0.f;
+        size_t bytes = 0;
+        /// The update the model was last needed in
+        uint64_t lastUsed = 0;
+        /// The TXD's file name, empty if there's none
+        std::string dictionary;
+        bool loading = false;
+        /// The file couldn't be loaded, so it isn't requested again
+        bool failed = false;
+        /// Loaded here rather than by GameData
+        bool owned = false;
+    };
+
+    GameData* m_data;
+    WorkContext* m_work;
+    CancelToken::Handle m_cancel;
+    size_t m_budget;
+
+    std::unordered_map<ModelID, Asset> m_assets;
+    std::unordered_map<std::string, Dictionary> m_dictionaries;
+
+    uint64_t m_frame = 0;
+    size_t m_loadedBytes = 0;
+    size_t m_loading = 0;
+    size_t m_evicted = 0;
+
+    Asset& getAsset(SimpleModelInfo* info);
+
+    void requestModel(SimpleModelInfo* info, Asset& asset);
+    void completeModel(ModelID id, const FileHandle& file);
+    void completeDictionary(const std::string& name, size_t bytes);
+
+    /// The static instances' bounds change with the models they draw
+    void updateBounds(const Asset& asset);
+
+    void evict();
+    void evictDictionary(const std::string& name, Dictionary& dictionary);
+};
+
+#endif
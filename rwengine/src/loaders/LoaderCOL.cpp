@@ -23,6 +23,10 @@ bool LoaderCOL::load(const std::string& path) {
     size_t length = file.tellg();
     file.seekg(0);
 
+    auto separator = path.find_last_of("/\\");
+    auto fileName =
+        separator == path.npos ? path : path.substr(separator + 1);
+
     std::vector<char> buffer(length);
     auto d = buffer.data();
     file.read(d, length);
@@ -40,6 +44,7 @@ bool LoaderCOL::load(const std::string& path) {
         auto model = std::make_unique<CollisionModel>();
         model->name = head.name;
         model->modelid = head.modelid;
+        model->file = fileName;
 
         auto readFloat = [&]() {
             auto f = (float*)d;
@@ -37,6 +37,12 @@ class GameObject {
 
 protected:
     void changeModelInfo(BaseModelInfo* next) {
+        if (next) {
+            next->addReference();
+        }
+        if (modelinfo_) {
+            modelinfo_->removeReference();
+        }
         modelinfo_ = next;
     }
 
@@ -30,6 +30,9 @@ InstanceObject::InstanceObject(GameWorld* engine, const glm::vec3& pos,
 }
 
 InstanceObject::~InstanceObject() {
+    if (streamed) {
+        engine->data->streaming->removeInstance(this);
+    }
 }
 
 void InstanceObject::tick(float dt) {
@@ -124,13 +127,24 @@ void InstanceObject::changeModel(BaseModelInfo* incoming) {
     }
 
     if (incoming) {
-        if (!incoming->isLoaded()) {
-            engine->data->loadModel(incoming->id());
-        }
+        auto streaming = engine->data->streaming.get();
+        if (streaming) {
+            if (streamed) {
+                streaming->removeInstance(this);
+            }
+            // The model is given to the instance once it is streamed in
+            changeModelInfo(incoming);
+            streaming->addInstance(this);
+            streamed = true;
+        } else {
+            if (!incoming->isLoaded()) {
+                engine->data->loadModel(incoming->id());
+            }
 
-        changeModelInfo(incoming);
-        /// @todo this should only be temporary
-        setModel(getModelInfo<SimpleModelInfo>()->getModel());
+            changeModelInfo(incoming);
+            /// @todo this should only be temporary
+            setModel(getModelInfo<SimpleModelInfo>()->getModel());
+        }
         auto collision = getModelInfo<SimpleModelInfo>()->getCollision();
 
         if (collision) {
@@ -141,6 +155,20 @@ void InstanceObject::changeModel(BaseModelInfo* incoming) {
     }
 }
 
+const InstanceRenderRecord& InstanceObject::getRenderRecord() {
+    auto info = getModelInfo<SimpleModelInfo>();
+    SimpleModelInfo* lodInfo = nullptr;
+    Model* lodModel = nullptr;
+    if (LODinstance) {
+        lodInfo = LODinstance->getModelInfo<SimpleModelInfo>();
+        lodModel = LODinstance->getModel();
+    }
+    if (!renderRecord.isBuiltFor(info, getModel(), lodInfo, lodModel)) {
+        renderRecord.build(info, getModel(), lodInfo, lodModel);
+    }
+    return renderRecord;
+}
+
 void InstanceObject::setRotation(const glm::quat& r) {
     if (body) {
         auto& wtr = body->getBulletBody()->getWorldTransform();
@@ -3,6 +3,7 @@
 #define _OBJECTINSTANCE_HPP_
 #include <btBulletDynamicsCommon.h>
 #include <objects/GameObject.hpp>
+#include <render/InstanceRenderRecord.hpp>
 
 class CollisionInstance;
 
@@ -13,6 +14,9 @@ class CollisionInstance;
 class InstanceObject : public GameObject {
     float health;
     bool visible = true;
+    InstanceRenderRecord renderRecord;
+    /// Added to GameData::streaming, which sets the model
+    bool streamed = false;
 
 public:
     glm::vec3 scale;
@@ -20,6 +24,8 @@ public:
     InstanceObject* LODinstance;
     std::shared_ptr<DynamicObjectData> dynamics;
     bool _enablePhysics;
+    /// Set while the instance is culled by GameWorld::staticInstances
+    bool staticInstance = false;
 
     InstanceObject(GameWorld* engine, const glm::vec3& pos,
                    const glm::quat& rot, const glm::vec3& scale,
@@ -51,6 +57,20 @@ public:
     float getHealth() const {
         return health;
     }
+
+    /**
+     * @brief Rebuilds the render record if the models it was built from
+     * have changed, such as after being streamed or linked to a LOD
+     */
+    const InstanceRenderRecord& getRenderRecord();
+
+    /**
+     * @brief Forgets the render record, for when a model it was built from
+     * is freed
+     */
+    void resetRenderRecord() {
+        renderRecord = InstanceRenderRecord();
+    }
 };
 
 #endif
@@ -21,14 +21,25 @@
 #include <core/Logger.hpp>
 #include <render/GameShaders.hpp>
 
+#include <algorithm>
 #include <deque>
 #include <glm/gtc/constants.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/string_cast.hpp>
 
 #include <core/Profiler.hpp>
+#include <job/WorkContext.hpp>
 
 const size_t skydomeSegments = 8, skydomeRows = 10;
+/// Objects listed per render list chunk, large enough to amortise the
+/// hand-off to the worker pool.
+constexpr size_t kRenderListGrain = 256;
+/// Instances further away than this aren't considered as occluders
+constexpr float kOccluderDistance = 200.f;
+/// Occluders rasterized each frame, those covering the most of the view win
+constexpr size_t kMaxOccluders = 64;
+/// Occlusion buffer rows rasterized per chunk
+constexpr size_t kOcclusionRowGrain = 16;
 constexpr uint32_t kMissingTextureBytes[] = {
     0xFF0000FF, 0xFFFF00FF, 0xFF0000FF, 0xFFFF00FF, 0xFFFF00FF, 0xFF0000FF,
     0xFFFF00FF, 0xFF0000FF, 0xFF0000FF, 0xFFFF00FF, 0xFF0000FF, 0xFFFF00FF,
@@ -73,6 +84,8 @@ GameRenderer::GameRenderer(Logger* log, GameData* _data)
     , _renderAlpha(0.f)
     , _renderWorld(nullptr)
     , cullOverride(false)
+    , occlusionCulling(false)
+    , cacheStaticDraws(false)
     , map(renderer, _data)
     , water(this)
     , text(this) {
@@ -83,6 +96,8 @@ GameRenderer::GameRenderer(Logger* log, GameData* _data)
                                GameShaders::WorldObject::FragmentShader);
 
     renderer->setUniformTexture(worldProg, "texture", 0);
+    renderer->setUniformTexture(worldProg, "texArray",
+                                Renderer::kTextureArrayUnit);
     renderer->setProgramBlockBinding(worldProg, "SceneData", 1);
     renderer->setProgramBlockBinding(worldProg, "ObjectData", 2);
 
@@ -227,6 +242,75 @@ void GameRenderer::setupRender() {
     glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
 }
 
+void GameRenderer::buildOcclusionBuffer(const ViewCamera& renderCamera) {
+    ViewCamera camera = renderCamera;
+    auto viewProjection = camera.frustum.projection() * camera.getView();
+
+    // Candidates come from a shortened frustum, only nearby instances are
+    // large enough on screen to be worth rasterizing.
+    camera.frustum.far = std::min(camera.frustum.far, kOccluderDistance);
+    camera.frustum.update(camera.frustum.projection() * camera.getView());
+    occluderCandidates.clear();
+    _renderWorld->staticInstances.findVisible(camera.frustum,
+                                              occluderCandidates);
+
+    // An occluder has to be drawn whole and opaque, so anything that may be
+    // faded, swapped for its LOD or hidden at this time of day is left out.
+    // The collision boxes stand in for the model.
+    occluders.clear();
+    for (auto object : occluderCandidates) {
+        auto instance = static_cast<InstanceObject*>(object);
+        if (!instance->getVisible() || !instance->getModel()) {
+            continue;
+        }
+        auto modelinfo = instance->getModelInfo<SimpleModelInfo>();
+        auto collision = modelinfo->getCollision();
+        if (!collision || collision->boxes.empty()) {
+            continue;
+        }
+        if (modelinfo->getNumAtomics() != 1 || modelinfo->LOD ||
+            modelinfo->timeOn != 0 || modelinfo->timeOff != 24) {
+            continue;
+        }
+        if (modelinfo->flags & (SimpleModelInfo::DRAW_LAST |
+                                SimpleModelInfo::ADDITIVE |
+                                SimpleModelInfo::NO_ZBUFFER_WRITE)) {
+            continue;
+        }
+        float distance =
+            glm::length(instance->getPosition() - camera.position);
+        if (distance - instance->getModel()->getBoundingRadius() >
+            modelinfo->getLodDistance(0)) {
+            continue;
+        }
+        float coverage =
+            collision->boundingSphere.radius / std::max(distance, 1.f);
+        occluders.emplace_back(coverage, instance);
+    }
+
+    auto count = std::min(occluders.size(), kMaxOccluders);
+    std::partial_sort(
+        occluders.begin(), occluders.begin() + count, occluders.end(),
+        [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    occlusionBuffer.clear(viewProjection);
+    for (size_t i = 0; i < count; ++i) {
+        auto instance = occluders[i].second;
+        auto model = instance->getTimeAdjustedTransform(_renderAlpha);
+        auto modelinfo = instance->getModelInfo<SimpleModelInfo>();
+        for (auto& box : modelinfo->getCollision()->boxes) {
+            occlusionBuffer.addBox(model, box.min, box.max);
+        }
+    }
+
+    data->workContext->parallelFor(
+        occlusionBuffer.getHeight(), kOcclusionRowGrain,
+        [&](size_t, size_t begin, size_t end) {
+            occlusionBuffer.rasterize(static_cast<int>(begin),
+                                      static_cast<int>(end));
+        });
+}
+
 void GameRenderer::renderWorld(GameWorld* world, const ViewCamera& camera,
                                float alpha) {
     _renderAlpha = alpha;
@@ -238,6 +322,8 @@ void GameRenderer::renderWorld(GameWorld* world, const ViewCamera& camera,
     setupRender();
 
     glBindVertexArray(vao);
+    // Streaming may have freed draw buffers, new ones can reuse addresses
+    renderer->invalidate();
 
     float tod = world->getHour() + world->getMinute() / 60.f;
 
@@ -284,6 +370,11 @@ void GameRenderer::renderWorld(GameWorld* world, const ViewCamera& camera,
 
     culled = 0;
 
+    // Textures packed since the last frame need the mipmaps of their arrays
+    if (data->textureArrays) {
+        data->textureArrays->generateMipmaps();
+    }
+
     renderer->useProgram(worldProg);
 
     //===============================================================
@@ -292,21 +383,91 @@ void GameRenderer::renderWorld(GameWorld* world, const ViewCamera& camera,
 
     RW_PROFILE_BEGIN("RenderList");
 
-    // This is sequential at the moment, it should be easy to make it
-    // run in parallel with a good threading system.
-    RenderList renderList;
-    // Naive optimisation, assume 50% hitrate
-    renderList.reserve(world->allObjects.size() * 0.5f);
+    renderList.clear();
 
     RW_PROFILE_BEGIN("Build");
 
-    ObjectRenderer objectRenderer(_renderWorld,
-                                  (cullOverride ? cullingCamera : _camera),
-                                  _renderAlpha, getMissingTexture());
+    const auto& renderCamera = cullOverride ? cullingCamera : _camera;
+    ObjectRenderer objectRenderer(_renderWorld, renderCamera, _renderAlpha,
+                                  getMissingTexture(), keyLayout);
+
+    // Objects can be attached to another object's skeleton, so all of the
+    // skeletons are interpolated before any lists are built.
+    for (auto object : world->allObjects) {
+        if (object->skeleton) {
+            object->skeleton->interpolate(_renderAlpha);
+        }
+    }
 
-    // World Objects
+    // Static instances are culled in bulk by the world's tree, the remaining
+    // objects are all considered.
+    RW_PROFILE_BEGIN("Cull");
+    const OcclusionBuffer* occlusion = nullptr;
+    if (occlusionCulling) {
+        RW_PROFILE_BEGIN("Occluders");
+        buildOcclusionBuffer(renderCamera);
+        RW_PROFILE_END();
+        if (occlusionBuffer.getTriangleCount() > 0) {
+            occlusion = &occlusionBuffer;
+        }
+    }
+    visibleObjects.clear();
+    visibleStatic.clear();
+    world->staticInstances.findVisible(
+        renderCamera.frustum, cacheStaticDraws ? visibleStatic : visibleObjects,
+        occlusion);
     for (auto object : world->allObjects) {
-        objectRenderer.buildRenderList(object, renderList);
+        if (!StaticInstanceTree::contains(object)) {
+            visibleObjects.push_back(object);
+        }
+    }
+    RW_PROFILE_END();
+
+    // Static instances listed by the cache come first, then everything else
+    // is listed after them.
+    if (cacheStaticDraws) {
+        RW_PROFILE_BEGIN("Static");
+        staticCache.update(visibleStatic, renderCamera, world->getHour(),
+                           objectRenderer, getMissingTexture(),
+                           *data->workContext);
+        renderList.instructions = staticCache.getList().instructions;
+        renderList.transforms = staticCache.getList().transforms;
+        RW_PROFILE_END();
+    } else {
+        staticCache.clear();
+    }
+
+    // World Objects, listed in parallel into a list per chunk. The lists are
+    // merged in chunk order so the result doesn't depend on the scheduling.
+    const auto& objects = visibleObjects;
+    auto chunks = (objects.size() + kRenderListGrain - 1) / kRenderListGrain;
+    if (chunkLists.size() < chunks) {
+        chunkLists.resize(chunks);
+    }
+    data->workContext->parallelFor(
+        objects.size(), kRenderListGrain,
+        [&](size_t chunk, size_t begin, size_t end) {
+            ObjectRenderer chunkRenderer(_renderWorld, renderCamera,
+                                         _renderAlpha, getMissingTexture(),
+                                         keyLayout);
+            auto& list = chunkLists[chunk];
+            list.clear();
+            for (auto i = begin; i < end; ++i) {
+                chunkRenderer.buildRenderList(objects[i], list);
+            }
+        });
+
+    size_t instructionCount = 0, transformCount = 0;
+    for (size_t c = 0; c < chunks; ++c) {
+        instructionCount += chunkLists[c].instructions.size();
+        transformCount += chunkLists[c].transforms.size();
+    }
+    renderList.instructions.reserve(renderList.instructions.size() +
+                                    instructionCount);
+    renderList.transforms.reserve(renderList.transforms.size() +
+                                  transformCount);
+    for (size_t c = 0; c < chunks; ++c) {
+        renderList.append(chunkLists[c]);
     }
 
     // Area indicators
@@ -355,17 +516,15 @@ void GameRenderer::renderWorld(GameWorld* world, const ViewCamera& camera,
     renderer->pushDebugGroup("Objects");
     renderer->pushDebugGroup("RenderList");
 
-    // Also parallelizable
     RW_PROFILE_BEGIN("Sort");
-    std::sort(renderList.begin(), renderList.end(),
-              [](const Renderer::RenderInstruction& a,
-                 const Renderer::RenderInstruction& b) {
-                  return a.sortKey < b.sortKey;
-              });
+    auto& renderOrder = cacheStaticDraws
+                            ? renderSorter.sort(renderList,
+                                                staticCache.getOrder())
+                            : renderSorter.sort(renderList);
     RW_PROFILE_END();
 
     RW_PROFILE_BEGIN("Draw");
-    renderer->drawBatched(renderList);
+    renderer->drawBatched(renderList, renderOrder);
     RW_PROFILE_END();
 
     renderer->popDebugGroup();
@@ -506,6 +665,7 @@ void GameRenderer::renderGeometry(Model* model, size_t g,
                 }
                 if (tex) {
                     dp.textures = {tex->getName()};
+                    dp.textureLayer = tex->getLayer();
                 }
             }
 
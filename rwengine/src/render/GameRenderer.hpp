@@ -7,11 +7,15 @@ class Logger;
 #include <gl/gl_core_3_3.h>
 
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include <render/ViewCamera.hpp>
 
+#include <render/OcclusionBuffer.hpp>
 #include <render/OpenGLRenderer.hpp>
+#include <render/RenderSort.hpp>
+#include <render/StaticRenderCache.hpp>
 #include "MapRenderer.hpp"
 #include "TextRenderer.hpp"
 #include "WaterRenderer.hpp"
@@ -95,6 +99,35 @@ class GameRenderer {
     /// Texture used to replace textures missing from the data
     GLuint m_missingTexture;
 
+    /// Objects that passed culling this frame
+    std::vector<GameObject*> visibleObjects;
+    /// Static instances that passed culling, when they are listed by
+    /// staticCache
+    std::vector<GameObject*> visibleStatic;
+
+    /// Static instance draws kept between frames
+    StaticRenderCache staticCache;
+
+    /// Depth of the nearest occluders, used to cull static instances
+    OcclusionBuffer occlusionBuffer;
+    /// Static instances near enough to be considered as occluders, and
+    /// those picked with how much of the view they cover
+    std::vector<GameObject*> occluderCandidates;
+    std::vector<std::pair<float, InstanceObject*>> occluders;
+
+    /**
+     * @brief Rasterizes the largest nearby instances into occlusionBuffer
+     */
+    void buildOcclusionBuffer(const ViewCamera& camera);
+
+    /// Render lists for the whole frame and each chunk of objects, kept to
+    /// reuse their storage
+    RenderList renderList;
+    std::vector<RenderList> chunkLists;
+
+    /// Orders the object render list for drawing
+    RenderSorter renderSorter;
+
 public:
     GameRenderer(Logger* log, GameData* data);
     ~GameRenderer();
@@ -102,6 +135,15 @@ public:
     /** Number of culling events */
     size_t culled;
 
+    /** How object draws are ordered, to minimise state changes */
+    RenderKeyLayout keyLayout;
+
+    /** Skip static instances hidden behind nearby buildings */
+    bool occlusionCulling;
+
+    /** Keep the static instances' draws between frames */
+    bool cacheStaticDraws;
+
     /** @todo Clean up all these shader program and location variables */
     Renderer::ShaderProgram* worldProg;
     Renderer::ShaderProgram* skyProg;
@@ -152,6 +152,10 @@ out vec3 Normal;
 out vec2 TexCoords;
 out vec4 Colour;
 out vec4 WorldSpace;
+flat out vec4 ObjectColour;
+flat out float AmbientFactor;
+flat out float Visibility;
+flat out float Layer;
 
 layout(std140) uniform SceneData {
 	mat4 projection;
@@ -164,12 +168,19 @@ layout(std140) uniform SceneData {
 	float fogEnd;
 };
 
-layout(std140) uniform ObjectData {
+struct ObjectParameters {
 	mat4 model;
 	vec4 colour;
 	float diffusefac;
 	float ambientfac;
 	float visibility;
+	float layer;
+};
+
+// Instanced draws index this by instance, single draws use the first entry.
+// Keep the size in sync with OpenGLRenderer::kMaxInstances
+layout(std140) uniform ObjectData {
+	ObjectParameters objects[128];
 };
 
 void main()
@@ -177,7 +188,11 @@ void main()
 	Normal = normal;
 	TexCoords = texCoords;
 	Colour = _colour;
-	vec4 worldspace = model * vec4(position, 1.0);
+	ObjectColour = objects[gl_InstanceID].colour;
+	AmbientFactor = objects[gl_InstanceID].ambientfac;
+	Visibility = objects[gl_InstanceID].visibility;
+	Layer = objects[gl_InstanceID].layer;
+	vec4 worldspace = objects[gl_InstanceID].model * vec4(position, 1.0);
 	vec4 viewspace = view * worldspace;
 	gl_Position = projection * viewspace;
 
@@ -191,7 +206,12 @@ in vec3 Normal;
 in vec2 TexCoords;
 in vec4 Colour;
 in vec4 WorldSpace;
+flat in vec4 ObjectColour;
+flat in float AmbientFactor;
+flat in float Layer;
 uniform sampler2D tex;
+// Packed textures are a layer of this instead of tex
+uniform sampler2DArray texArray;
 out vec4 fragOut;
 
 layout(std140) uniform SceneData {
@@ -205,23 +225,19 @@ layout(std140) uniform SceneData {
 	float fogEnd;
 };
 
-layout(std140) uniform ObjectData {
-	mat4 model;
-	vec4 colour;
-	float diffusefac;
-	float ambientfac;
-	float visibility;
-};
-
 float alphaThreshold = (1.0/255.0);
 
 void main()
 {
 	// Only the visibility parameter invokes the screen door.
 	vec4 diffuse = Colour;
-	diffuse.rgb += ambient.rgb*ambientfac;
-	diffuse *= colour;
-	diffuse *= texture(tex, TexCoords);
+	diffuse.rgb += ambient.rgb*AmbientFactor;
+	diffuse *= ObjectColour;
+	if (Layer >= 0.0) {
+		diffuse *= texture(texArray, vec3(TexCoords, Layer));
+	} else {
+		diffuse *= texture(tex, TexCoords);
+	}
 	if(diffuse.a <= alphaThreshold) discard;
 	float fog = 1.0 - clamp( (fogEnd-WorldSpace.w)/(fogEnd-fogStart), 0.0, 1.0 );
 	fragOut = vec4(mix(diffuse.rgb, fogColor.rgb, fog), diffuse.a);
@@ -233,6 +249,8 @@ const char* Particle::FragmentShader = R"(
 in vec3 Normal;
 in vec2 TexCoords;
 in vec4 Colour;
+flat in vec4 ObjectColour;
+flat in float Visibility;
 uniform sampler2D tex;
 out vec4 outColour;
 
@@ -247,14 +265,6 @@ layout(std140) uniform SceneData {
 	float fogEnd;
 };
 
-layout(std140) uniform ObjectData {
-	mat4 model;
-	vec4 colour;
-	float diffusefac;
-	float ambientfac;
-	float visibility;
-};
-
 #define ALPHA_DISCARD_THRESHOLD 0.01
 
 void main()
@@ -264,7 +274,7 @@ void main()
 	if(c.a <= ALPHA_DISCARD_THRESHOLD) discard;
 	float fogZ = (gl_FragCoord.z / gl_FragCoord.w);
 	float fogfac = clamp( (fogStart-fogZ)/(fogEnd-fogStart), 0.0, 1.0 );
-	vec4 tint = vec4(colour.rgb, visibility);
+	vec4 tint = vec4(ObjectColour.rgb, Visibility);
 	outColour = c * tint;
 })";
 
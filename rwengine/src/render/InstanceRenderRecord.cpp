@@ -0,0 +1,120 @@
+#include <render/InstanceRenderRecord.hpp>
+
+#include <data/Model.hpp>
+#include <data/ModelData.hpp>
+
+#include <cmath>
+
+constexpr float InstanceRenderRecord::kDrawDistanceFactor;
+constexpr float InstanceRenderRecord::kFadeRange;
+
+namespace {
+/// Comparing squared distances against a negative limit never passes
+float square(float distance) {
+    return distance < 0.f ? -1.f : distance * distance;
+}
+
+bool isShown(const SimpleModelInfo* info, int hour) {
+    if (info->timeOff < info->timeOn) {
+        return hour < info->timeOff || hour >= info->timeOn;
+    }
+    return hour >= info->timeOn && hour < info->timeOff;
+}
+}
+
+void InstanceRenderRecord::build(SimpleModelInfo* info, Model* model,
+                                 SimpleModelInfo* lodInfo, Model* lodModel) {
+    *this = InstanceRenderRecord();
+    this->info = info;
+    this->model = model;
+    this->lodInfo = lodInfo;
+    this->lodModel = lodModel;
+
+    if (info == nullptr || model == nullptr || model->frames.empty()) {
+        return;
+    }
+
+    for (int hour = 0; hour < 24; ++hour) {
+        if (isShown(info, hour)) {
+            hours |= 1u << hour;
+        }
+    }
+
+    atomics = info->getNumAtomics();
+    isLOD = info->LOD;
+    radius = model->getBoundingRadius();
+
+    // A level is drawn while (distance - radius) / factor <= its distance
+    auto setLevel = [&](int level, float distance, ModelFrame* frame) {
+        distances[level] = distance;
+        if (frame) {
+            drawDistances2[level] =
+                square(distance * kDrawDistanceFactor + radius);
+            fadeDistances2[level] = square(
+                (distance + kFadeRange) * kDrawDistanceFactor + radius);
+            frames[level] = frame;
+            inverseFrames[level] = glm::inverse(frame->getTransform());
+        }
+    };
+
+    if (atomics == 1) {
+        setLevel(0, info->getLodDistance(0), model->frames[0]);
+        if (lodInfo) {
+            // Without its model the LOD still stops the fade
+            bool lodLoaded = lodModel && !lodModel->frames.empty();
+            setLevel(1, lodInfo->getLodDistance(0),
+                     lodLoaded ? lodModel->frames[0] : nullptr);
+        }
+    } else {
+        auto& children = model->frames[0]->getChildren();
+        for (int i = 0; i + 1 < atomics && i < 2; ++i) {
+            size_t child = atomics - 1 - i;
+            setLevel(i, info->getLodDistance(i),
+                     child < children.size() ? children[child] : nullptr);
+        }
+    }
+}
+
+InstanceRenderRecord::Selection InstanceRenderRecord::select(
+    float distance2) const {
+    Selection selection;
+
+    auto fade = [&](int level) {
+        selection.fading = level;
+        if (distance2 < fadeDistances2[level]) {
+            float mindist =
+                (std::sqrt(distance2) - radius) / kDrawDistanceFactor;
+            selection.opacity = 1.f - (mindist - distances[level]) / kFadeRange;
+        } else {
+            selection.opacity = 0.f;
+        }
+    };
+
+    if (atomics == 1) {
+        if (distance2 <= drawDistances2[0]) {
+            if (!isLOD) {
+                selection.draw = 0;
+            }
+        } else if (lodInfo) {
+            if (distance2 <= drawDistances2[1]) {
+                selection.draw = 1;
+                if (distance2 < fadeDistances2[0]) {
+                    fade(0);
+                }
+            }
+        } else if (distance2 < fadeDistances2[0]) {
+            fade(0);
+        }
+    } else {
+        // The lowest level in range wins, as does the last one out of range
+        for (int i = 0; i + 1 < atomics && i < 2; ++i) {
+            if (distance2 <= drawDistances2[i]) {
+                selection.draw = i;
+            } else {
+                fade(i);
+            }
+        }
+    }
+
+    return selection;
+}
@@ -0,0 +1,84 @@
+#ifndef _RWENGINE_INSTANCERENDERRECORD_HPP_
+#define _RWENGINE_INSTANCERENDERRECORD_HPP_
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+class Model;
+class ModelFrame;
+class SimpleModelInfo;
+
+/**
+ * @brief What ObjectRenderer needs to choose an instance's models, worked
+ * out once rather than every frame
+ *
+ * Each level of detail is kept with the squared camera distances it is
+ * drawn and faded out within, so choosing one needs no square root unless
+ * something is fading. The hours the model is shown are kept as a mask,
+ * and the inverse transforms of the frames drawn are cached.
+ *
+ * For single atomic models level 0 is the model and level 1 the LOD
+ * instance's model. Otherwise the levels are the atomics' frames.
+ */
+struct InstanceRenderRecord {
+    /// Scales the draw distances of every level
+    static constexpr float kDrawDistanceFactor = 1.0f;
+    /// Distance past a level's draw distance over which it fades out
+    static constexpr float kFadeRange = 50.f;
+
+    /// What to draw at some distance, levels are -1 if there's none
+    struct Selection {
+        int draw = -1;
+        int fading = -1;
+        float opacity = 0.f;
+    };
+
+    /// What the record was built from, it is stale once any change
+    const SimpleModelInfo* info = nullptr;
+    Model* model = nullptr;
+    const SimpleModelInfo* lodInfo = nullptr;
+    Model* lodModel = nullptr;
+
+    /// Bit n is set if the model is shown during hour n
+    uint32_t hours = 0;
+    uint8_t atomics = 0;
+    /// The model only stands in for others
+    bool isLOD = false;
+    float radius = 0.f;
+
+    /// Unsquared draw distance of each level, for working out opacity
+    float distances[2] = {};
+    /// Squared camera distances each level is drawn within, negative if
+    /// never
+    float drawDistances2[2] = {-1.f, -1.f};
+    /// Squared camera distances each level fades out within
+    float fadeDistances2[2] = {-1.f, -1.f};
+
+    ModelFrame* frames[2] = {};
+    glm::mat4 inverseFrames[2];
+
+    /**
+     * @param lodInfo The LOD instance's model info, if it has one
+     */
+    void build(SimpleModelInfo* info, Model* model, SimpleModelInfo* lodInfo,
+               Model* lodModel);
+
+    bool isBuiltFor(const SimpleModelInfo* info, const Model* model,
+                    const SimpleModelInfo* lodInfo,
+                    const Model* lodModel) const {
+        return this->info == info && this->model == model &&
+               this->lodInfo == lodInfo && this->lodModel == lodModel;
+    }
+
+    bool isShownAt(int hour) const {
+        return hour >= 0 && hour < 32 && ((hours >> hour) & 1) != 0;
+    }
+
+    /**
+     * @param distance2 Squared distance from the camera to the instance
+     */
+    Selection select(float distance2) const;
+};
+
+#endif
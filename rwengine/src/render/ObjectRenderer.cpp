@@ -4,6 +4,7 @@
 #include <engine/GameData.hpp>
 #include <engine/GameState.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <memory>
 #include <render/ObjectRenderer.hpp>
 
 // Objects that we know how to turn into renderlist entries
@@ -17,25 +18,23 @@
 #include <rw_mingw.hpp>
 #endif
 
-constexpr float kDrawDistanceFactor = 1.0f;
+constexpr float kDrawDistanceFactor = InstanceRenderRecord::kDrawDistanceFactor;
 constexpr float kWorldDrawDistanceFactor = kDrawDistanceFactor;
 #if 0  // There's no distance based culling for these types of objects yet
 constexpr float kVehicleDrawDistanceFactor = kDrawDistanceFactor;
 constexpr float kPedestrianDrawDistanceFactor = kDrawDistanceFactor;
 #endif
 
-RenderKey createKey(bool transparent, float normalizedDepth,
-                    Renderer::Textures& textures) {
-    return ((transparent ? 0x1 : 0x0) << 31) |
-           uint32_t(0x7FFFFF *
-                    (transparent ? 1.f - normalizedDepth : normalizedDepth))
-               << 8 |
-           uint8_t(0xFF & (textures.size() > 0 ? textures[0] : 0)) << 0;
-}
-
 void ObjectRenderer::renderGeometry(Model* model, size_t g,
                                     const glm::mat4& modelMatrix, float opacity,
                                     GameObject* object, RenderList& outList) {
+    if (model->geometries[g]->subgeom.empty()) {
+        return;
+    }
+
+    // Every part of the geometry is drawn with the same matrix
+    auto transform = outList.addTransform(modelMatrix);
+
     for (size_t sg = 0; sg < model->geometries[g]->subgeom.size(); ++sg) {
         Model::SubGeometry& subgeom = model->geometries[g]->subgeom[sg];
 
@@ -60,7 +59,9 @@ void ObjectRenderer::renderGeometry(Model* model, size_t g,
                 model->geometries[g]->materials[subgeom.material];
 
             if (mat.textures.size() > 0) {
-                auto tex = mat.textures[0].texture;
+                // Materials are shared between objects being listed on other
+                // threads, so the texture is resolved atomically.
+                auto tex = std::atomic_load(&mat.textures[0].texture);
                 if (!tex) {
                     auto& tC = mat.textures[0].name;
                     auto& tA = mat.textures[0].alphaName;
@@ -69,14 +70,16 @@ void ObjectRenderer::renderGeometry(Model* model, size_t g,
                         // logger->warning("Renderer", "Missing texture: " + tC
                         // + " " + tA);
                         dp.textures = {m_errorTexture};
+                    } else {
+                        std::atomic_store(&mat.textures[0].texture, tex);
                     }
-                    mat.textures[0].texture = tex;
                 }
                 if (tex) {
                     if (tex->isTransparent()) {
                         isTransparent = true;
                     }
                     dp.textures = {tex->getName()};
+                    dp.textureLayer = tex->getLayer();
                 }
             }
 
@@ -109,15 +112,25 @@ void ObjectRenderer::renderGeometry(Model* model, size_t g,
 
         dp.blend = isTransparent;
 
-        glm::vec3 position(modelMatrix[3]);
-        float distance = glm::length(m_camera.position - position);
-        float depth = (distance - m_camera.frustum.near) /
-                      (m_camera.frustum.far - m_camera.frustum.near);
-        outList.emplace_back(
-            createKey(isTransparent, depth * depth, dp.textures), modelMatrix,
-            &model->geometries[g]->dbuff, dp);
+        auto& dbuff = model->geometries[g]->dbuff;
+        outList.addInstruction(getSortKey(modelMatrix, dbuff, dp), transform,
+                               &dbuff, dp);
     }
 }
+
+RenderKey ObjectRenderer::getSortKey(const glm::mat4& modelMatrix,
+                                     const DrawBuffer& dbuff,
+                                     const Renderer::DrawParameters& dp) const {
+    glm::vec3 position(modelMatrix[3]);
+    float distance = glm::length(m_camera.position - position);
+    float depth = (distance - m_camera.frustum.near) /
+                  (m_camera.frustum.far - m_camera.frustum.near);
+    auto texture = dp.textures.size() > 0 ? dp.textures[0] : 0;
+    return dp.blend ? m_keyLayout.translucent(texture, depth * depth)
+                    : m_keyLayout.opaque(dbuff.getVAOName(), texture,
+                                         depth * depth);
+}
+
 bool ObjectRenderer::renderFrame(Model* m, ModelFrame* f,
                                  const glm::mat4& matrix, GameObject* object,
                                  float opacity, RenderList& outList) {
@@ -165,111 +178,47 @@ void ObjectRenderer::renderInstance(InstanceObject* instance,
         return;
     }
 
-    auto modelinfo = instance->getModelInfo<SimpleModelInfo>();
+    auto& record = instance->getRenderRecord();
 
     // Handles times provided by TOBJ data
-    const auto currentHour = m_world->getHour();
-    if (modelinfo->timeOff < modelinfo->timeOn) {
-        if (currentHour >= modelinfo->timeOff &&
-            currentHour < modelinfo->timeOn)
-            return;
-    } else {
-        if (currentHour >= modelinfo->timeOff ||
-            currentHour < modelinfo->timeOn)
-            return;
+    if (!record.isShownAt(m_world->getHour())) {
+        return;
     }
 
-    auto matrixModel = instance->getTimeAdjustedTransform(m_renderAlpha);
+    auto offset = instance->getPosition() - m_camera.position;
+    auto selection = record.select(glm::dot(offset, offset));
 
-    float mindist = glm::length(instance->getPosition() - m_camera.position) -
-                    instance->getModel()->getBoundingRadius();
-    mindist *= 1.f / kDrawDistanceFactor;
-
-    Model* model = nullptr;
-    ModelFrame* frame = nullptr;
-
-    // These are used to gracefully fade out things that are just out of view
-    // distance.
-    Model* fadingModel = nullptr;
-    ModelFrame* fadingFrame = nullptr;
-    auto fadingMatrix = matrixModel;
-    float opacity = 0.f;
-    constexpr float fadeRange = 50.f;
-
-    /// @todo replace this block with the correct logic
-    if (modelinfo->getNumAtomics() == 1) {
-        // Is closest point greater than the *object* draw distance
-        float objectRange = modelinfo->getLodDistance(0);
-        float overlap = (mindist - objectRange);
-        if (mindist > objectRange) {
-            // Check for LOD instances
-            if (instance->LODinstance) {
-                // Is the closest point greater than the *LOD* draw distance
-                auto lodmodelinfo =
-                    instance->LODinstance->getModelInfo<SimpleModelInfo>();
-                float LODrange = lodmodelinfo->getLodDistance(0);
-                if (mindist <= LODrange && instance->LODinstance->getModel()) {
-                    // The model matrix needs to be for the LOD instead
-                    matrixModel =
-                        instance->LODinstance->getTimeAdjustedTransform(
-                            m_renderAlpha);
-                    // If the object is only just out of range, keep
-                    // rendering it and screen-door the LOD.
-                    if (overlap < fadeRange) {
-                        model = instance->LODinstance->getModel();
-                        fadingModel = instance->getModel();
-                        opacity = 1.f - (overlap / fadeRange);
-                    } else {
-                        model = instance->LODinstance->getModel();
-                    }
-                }
-            }
-            // We don't have a LOD object, so fade out gracefully.
-            else if (overlap < fadeRange) {
-                fadingModel = instance->getModel();
-                opacity = 1.f - (overlap / fadeRange);
-            }
-        }
-        // Otherwise, if we aren't marked as a LOD model, we can render
-        else if (!modelinfo->LOD) {
-            model = instance->getModel();
-        }
-    } else {
-        auto root = instance->getModel()->frames[0];
-        auto objectModel = instance->getModel();
-        fadingFrame = nullptr;
-        fadingModel = nullptr;
-
-        matrixModel *= root->getTransform();
-
-        for (int i = 0; i < modelinfo->getNumAtomics() - 1; ++i) {
-            auto ind = (modelinfo->getNumAtomics() - 1) - i;
-            float lodDistance = modelinfo->getLodDistance(i);
-            if (mindist > lodDistance) {
-                fadingFrame = root->getChildren()[ind];
-                fadingModel = objectModel;
-                opacity = 1.f - ((mindist - lodDistance) / fadeRange);
-            } else {
-                model = objectModel;
-                frame = root->getChildren()[ind];
-            }
-        }
+    bool fading = selection.fading >= 0 && selection.opacity >= 0.01f &&
+                  record.frames[selection.fading];
+    bool drawing = selection.draw >= 0 && record.frames[selection.draw];
+    if (!drawing && !fading) {
+        return;
     }
 
-    if (model) {
-        frame = frame ? frame : model->frames[0];
-        renderFrame(model, frame,
-                    matrixModel * glm::inverse(frame->getTransform()), instance,
+    auto matrixModel = instance->getTimeAdjustedTransform(m_renderAlpha);
+
+    if (drawing) {
+        Model* model = record.model;
+        glm::mat4 matrix;
+        if (record.atomics != 1) {
+            matrix = matrixModel * model->frames[0]->getTransform();
+        } else if (selection.draw == 1) {
+            // The model matrix needs to be for the LOD instead
+            model = record.lodModel;
+            matrix = instance->LODinstance->getTimeAdjustedTransform(
+                m_renderAlpha);
+        } else {
+            matrix = matrixModel;
+        }
+        renderFrame(model, record.frames[selection.draw],
+                    matrix * record.inverseFrames[selection.draw], instance,
                     1.f, outList);
     }
-    if (fadingModel) {
-        if (opacity >= 0.01f) {
-            fadingFrame = fadingFrame ? fadingFrame : fadingModel->frames[0];
-            renderFrame(
-                fadingModel, fadingFrame,
-                fadingMatrix * glm::inverse(fadingFrame->getTransform()),
-                instance, opacity, outList);
-        }
+    if (fading) {
+        // Gracefully fade out things that are just out of view distance
+        renderFrame(record.model, record.frames[selection.fading],
+                    matrixModel * record.inverseFrames[selection.fading],
+                    instance, selection.opacity, outList);
     }
 }
 
@@ -465,10 +414,6 @@ void ObjectRenderer::renderProjectile(ProjectileObject* projectile,
 }
 
 void ObjectRenderer::buildRenderList(GameObject* object, RenderList& outList) {
-    if (object->skeleton) {
-        object->skeleton->interpolate(m_renderAlpha);
-    }
-
     // Right now specialized on each object type
     switch (object->type()) {
         case GameObject::Instance:
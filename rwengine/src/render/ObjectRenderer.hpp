@@ -6,6 +6,7 @@
 #include <glm/glm.hpp>
 #include <objects/GameObject.hpp>
 #include <render/OpenGLRenderer.hpp>
+#include <render/RenderSort.hpp>
 #include <render/ViewCamera.hpp>
 #include <rw/types.hpp>
 
@@ -21,17 +22,22 @@ class PickupObject;
 class ObjectRenderer {
 public:
     ObjectRenderer(GameWorld* world, const ViewCamera& camera,
-                   float renderAlpha, GLuint errorTexture)
+                   float renderAlpha, GLuint errorTexture,
+                   const RenderKeyLayout& keyLayout = RenderKeyLayout())
         : m_world(world)
         , m_camera(camera)
         , m_renderAlpha(renderAlpha)
-        , m_errorTexture(errorTexture) {
+        , m_errorTexture(errorTexture)
+        , m_keyLayout(keyLayout) {
     }
 
     /**
      * @brief buildRenderList
      *
-     * Exports rendering instructions for an object
+     * Exports rendering instructions for an object. Skeletons must already be
+     * interpolated, since objects may read each other's skeletons. Distinct
+     * objects may be listed from different threads, each with its own
+     * ObjectRenderer.
      */
     void buildRenderList(GameObject* object, RenderList& outList);
 
@@ -41,11 +47,19 @@ public:
     void renderGeometry(Model* model, size_t g, const glm::mat4& modelMatrix,
                         float opacity, GameObject* object, RenderList& outList);
 
+    /**
+     * @return The key that orders a draw of dbuff with modelMatrix, for the
+     * camera being rendered
+     */
+    RenderKey getSortKey(const glm::mat4& modelMatrix, const DrawBuffer& dbuff,
+                         const Renderer::DrawParameters& dp) const;
+
 private:
     GameWorld* m_world;
     const ViewCamera& m_camera;
     float m_renderAlpha;
     GLuint m_errorTexture;
+    RenderKeyLayout m_keyLayout;
 
     void renderInstance(InstanceObject* instance, RenderList& outList);
     void renderCharacter(CharacterObject* pedestrian, RenderList& outList);
@@ -0,0 +1,324 @@
+#include <render/OcclusionBuffer.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define RW_OCCLUSION_SSE 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define RW_OCCLUSION_NEON 1
+#endif
+
+namespace {
+/// Depth of pixels that nothing has been drawn to, behind everything
+constexpr float kClearDepth = std::numeric_limits<float>::max();
+
+// Four lane operations, so the raster loops are written once
+#if RW_OCCLUSION_SSE
+typedef __m128 Float4;
+typedef __m128 Mask4;
+
+inline Float4 splat(float f) {
+    return _mm_set1_ps(f);
+}
+inline Float4 ramp() {
+    return _mm_setr_ps(0.f, 1.f, 2.f, 3.f);
+}
+inline Float4 load(const float* p) {
+    return _mm_loadu_ps(p);
+}
+inline void store(float* p, Float4 v) {
+    _mm_storeu_ps(p, v);
+}
+inline Float4 add(Float4 a, Float4 b) {
+    return _mm_add_ps(a, b);
+}
+inline Float4 mul(Float4 a, Float4 b) {
+    return _mm_mul_ps(a, b);
+}
+inline Float4 min(Float4 a, Float4 b) {
+    return _mm_min_ps(a, b);
+}
+inline Mask4 greaterEqual(Float4 a, Float4 b) {
+    return _mm_cmpge_ps(a, b);
+}
+inline Mask4 both(Mask4 a, Mask4 b) {
+    return _mm_and_ps(a, b);
+}
+inline Float4 select(Mask4 m, Float4 a, Float4 b) {
+    return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+}
+inline bool any(Mask4 m) {
+    return _mm_movemask_ps(m) != 0;
+}
+#elif RW_OCCLUSION_NEON
+typedef float32x4_t Float4;
+typedef uint32x4_t Mask4;
+
+inline Float4 splat(float f) {
+    return vdupq_n_f32(f);
+}
+inline Float4 ramp() {
+    const float lanes[4] = {0.f, 1.f, 2.f, 3.f};
+    return vld1q_f32(lanes);
+}
+inline Float4 load(const float* p) {
+    return vld1q_f32(p);
+}
+inline void store(float* p, Float4 v) {
+    vst1q_f32(p, v);
+}
+inline Float4 add(Float4 a, Float4 b) {
+    return vaddq_f32(a, b);
+}
+inline Float4 mul(Float4 a, Float4 b) {
+    return vmulq_f32(a, b);
+}
+inline Float4 min(Float4 a, Float4 b) {
+    return vminq_f32(a, b);
+}
+inline Mask4 greaterEqual(Float4 a, Float4 b) {
+    return vcgeq_f32(a, b);
+}
+inline Mask4 both(Mask4 a, Mask4 b) {
+    return vandq_u32(a, b);
+}
+inline Float4 select(Mask4 m, Float4 a, Float4 b) {
+    return vbslq_f32(m, a, b);
+}
+inline bool any(Mask4 m) {
+    return vmaxvq_u32(m) != 0;
+}
+#else
+struct Float4 {
+    float v[4];
+};
+struct Mask4 {
+    bool v[4];
+};
+
+inline Float4 splat(float f) {
+    return {{f, f, f, f}};
+}
+inline Float4 ramp() {
+    return {{0.f, 1.f, 2.f, 3.f}};
+}
+inline Float4 load(const float* p) {
+    return {{p[0], p[1], p[2], p[3]}};
+}
+inline void store(float* p, Float4 v) {
+    std::copy(v.v, v.v + 4, p);
+}
+inline Float4 add(Float4 a, Float4 b) {
+    return {{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2],
+             a.v[3] + b.v[3]}};
+}
+inline Float4 mul(Float4 a, Float4 b) {
+    return {{a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2],
+             a.v[3] * b.v[3]}};
+}
+inline Float4 min(Float4 a, Float4 b) {
+    return {{std::min(a.v[0], b.v[0]), std::min(a.v[1], b.v[1]),
+             std::min(a.v[2], b.v[2]), std::min(a.v[3], b.v[3])}};
+}
+inline Mask4 greaterEqual(Float4 a, Float4 b) {
+    return {{a.v[0] >= b.v[0], a.v[1] >= b.v[1], a.v[2] >= b.v[2],
+             a.v[3] >= b.v[3]}};
+}
+inline Mask4 both(Mask4 a, Mask4 b) {
+    return {{a.v[0] && b.v[0], a.v[1] && b.v[1], a.v[2] && b.v[2],
+             a.v[3] && b.v[3]}};
+}
+inline Float4 select(Mask4 m, Float4 a, Float4 b) {
+    return {{m.v[0] ? a.v[0] : b.v[0], m.v[1] ? a.v[1] : b.v[1],
+             m.v[2] ? a.v[2] : b.v[2], m.v[3] ? a.v[3] : b.v[3]}};
+}
+inline bool any(Mask4 m) {
+    return m.v[0] || m.v[1] || m.v[2] || m.v[3];
+}
+#endif
+
+/// Converts a pixel coordinate to a clamped integer bound
+int toPixel(float f, int limit) {
+    return static_cast<int>(std::min(std::max(f, 0.f), float(limit)));
+}
+}
+
+OcclusionBuffer::OcclusionBuffer(int width, int height)
+    : m_width((std::max(width, 4) + 3) & ~3)
+    , m_height(std::max(height, 1))
+    , m_depth(m_width * m_height, kClearDepth) {
+}
+
+void OcclusionBuffer::clear(const glm::mat4& viewProjection) {
+    m_viewProjection = viewProjection;
+    std::fill(m_depth.begin(), m_depth.end(), kClearDepth);
+    m_triangles.clear();
+}
+
+bool OcclusionBuffer::project(const glm::vec4& world, glm::vec3& out) const {
+    auto clip = m_viewProjection * world;
+    if (!(clip.z >= -clip.w) || !(clip.w > 0.f)) {
+        return false;
+    }
+    out.x = (clip.x / clip.w * 0.5f + 0.5f) * m_width;
+    out.y = (clip.y / clip.w * 0.5f + 0.5f) * m_height;
+    out.z = clip.z / clip.w * 0.5f + 0.5f;
+    return true;
+}
+
+void OcclusionBuffer::addBox(const glm::mat4& model, const glm::vec3& min,
+                             const glm::vec3& max) {
+    // Corner i takes max on the axes whose bit is set, x being bit 0
+    glm::vec3 corners[8];
+    for (int i = 0; i < 8; ++i) {
+        glm::vec4 corner(i & 1 ? max.x : min.x, i & 2 ? max.y : min.y,
+                         i & 4 ? max.z : min.z, 1.f);
+        if (!project(model * corner, corners[i])) {
+            return;
+        }
+    }
+
+    static const int kFaces[6][4] = {{0, 1, 3, 2}, {4, 5, 7, 6},
+                                     {0, 1, 5, 4}, {2, 3, 7, 6},
+                                     {0, 2, 6, 4}, {1, 3, 7, 5}};
+    for (auto& face : kFaces) {
+        addTriangle(corners[face[0]], corners[face[1]], corners[face[2]]);
+        addTriangle(corners[face[0]], corners[face[2]], corners[face[3]]);
+    }
+}
+
+void OcclusionBuffer::addTriangle(const glm::vec3& v0, const glm::vec3& v1,
+                                  const glm::vec3& v2) {
+    // Both windings are drawn, since the front faces aren't known
+    float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+    if (!(std::abs(area) > 1e-6f)) {
+        return;
+    }
+    const glm::vec3* v[3] = {&v0, &v1, &v2};
+    if (area < 0.f) {
+        std::swap(v[1], v[2]);
+        area = -area;
+    }
+
+    Triangle t;
+    t.minX = toPixel(std::floor(std::min({v0.x, v1.x, v2.x})), m_width);
+    t.maxX = toPixel(std::ceil(std::max({v0.x, v1.x, v2.x})), m_width);
+    t.minY = toPixel(std::floor(std::min({v0.y, v1.y, v2.y})), m_height);
+    t.maxY = toPixel(std::ceil(std::max({v0.y, v1.y, v2.y})), m_height);
+    if (t.minX >= t.maxX || t.minY >= t.maxY) {
+        return;
+    }
+
+    for (int e = 0; e < 3; ++e) {
+        auto& from = *v[e];
+        auto& to = *v[(e + 1) % 3];
+        t.a[e] = from.y - to.y;
+        t.b[e] = to.x - from.x;
+        t.c[e] = -(t.a[e] * from.x + t.b[e] * from.y);
+    }
+
+    auto& p0 = *v[0];
+    auto& p1 = *v[1];
+    auto& p2 = *v[2];
+    t.dzdx = ((p1.z - p0.z) * (p2.y - p0.y) - (p2.z - p0.z) * (p1.y - p0.y)) /
+             area;
+    t.dzdy = ((p2.z - p0.z) * (p1.x - p0.x) - (p1.z - p0.z) * (p2.x - p0.x)) /
+             area;
+    t.z0 = p0.z - t.dzdx * p0.x - t.dzdy * p0.y;
+
+    m_triangles.push_back(t);
+}
+
+void OcclusionBuffer::rasterize(int begin, int end) {
+    const Float4 lanes = ramp();
+    const Float4 zero = splat(0.f);
+
+    for (auto& t : m_triangles) {
+        auto minY = std::max(t.minY, begin);
+        auto maxY = std::min(t.maxY, end);
+        // Start on a group of four, the width is a multiple of four
+        auto minX = t.minX & ~3;
+
+        // Values at the centre of each pixel in the first group of a row,
+        // then stepped along by four pixels at a time
+        const Float4 px = add(splat(minX + 0.5f), lanes);
+        Float4 edgeX[3], edgeStep[3];
+        for (int e = 0; e < 3; ++e) {
+            edgeX[e] = mul(splat(t.a[e]), px);
+            edgeStep[e] = splat(t.a[e] * 4.f);
+        }
+        const Float4 depthX = mul(splat(t.dzdx), px);
+        const Float4 depthStep = splat(t.dzdx * 4.f);
+
+        for (int y = minY; y < maxY; ++y) {
+            float py = y + 0.5f;
+            Float4 e0 = add(edgeX[0], splat(t.b[0] * py + t.c[0]));
+            Float4 e1 = add(edgeX[1], splat(t.b[1] * py + t.c[1]));
+            Float4 e2 = add(edgeX[2], splat(t.b[2] * py + t.c[2]));
+            Float4 z = add(depthX, splat(t.dzdy * py + t.z0));
+
+            float* row = &m_depth[y * m_width];
+            for (int x = minX; x < t.maxX; x += 4) {
+                Mask4 inside = both(both(greaterEqual(e0, zero),
+                                         greaterEqual(e1, zero)),
+                                    greaterEqual(e2, zero));
+                Float4 depth = load(row + x);
+                store(row + x, select(inside, min(depth, z), depth));
+
+                e0 = add(e0, edgeStep[0]);
+                e1 = add(e1, edgeStep[1]);
+                e2 = add(e2, edgeStep[2]);
+                z = add(z, depthStep);
+            }
+        }
+    }
+}
+
+bool OcclusionBuffer::isVisible(const glm::vec3& min,
+                                const glm::vec3& max) const {
+    // The box's corners bound its extent on screen and its nearest depth
+    glm::vec3 lower(std::numeric_limits<float>::max());
+    glm::vec3 upper(-std::numeric_limits<float>::max());
+    for (int i = 0; i < 8; ++i) {
+        glm::vec4 corner(i & 1 ? max.x : min.x, i & 2 ? max.y : min.y,
+                         i & 4 ? max.z : min.z, 1.f);
+        glm::vec3 p;
+        if (!project(corner, p)) {
+            return true;
+        }
+        lower = glm::min(lower, p);
+        upper = glm::max(upper, p);
+    }
+
+    auto minX = toPixel(std::floor(lower.x), m_width);
+    auto maxX = toPixel(std::ceil(upper.x), m_width);
+    auto minY = toPixel(std::floor(lower.y), m_height);
+    auto maxY = toPixel(std::ceil(upper.y), m_height);
+    if (minX >= maxX || minY >= maxY) {
+        // Off screen, that's for the frustum to decide
+        return true;
+    }
+
+    const Float4 nearest = splat(lower.z);
+    const Float4 first = splat(float(minX));
+    const Float4 last = splat(float(maxX - 1));
+    const Float4 lanes = ramp();
+
+    for (int y = minY; y < maxY; ++y) {
+        const float* row = &m_depth[y * m_width];
+        for (int x = minX & ~3; x < maxX; x += 4) {
+            Float4 px = add(splat(float(x)), lanes);
+            Mask4 covered =
+                both(greaterEqual(px, first), greaterEqual(last, px));
+            if (any(both(covered, greaterEqual(load(row + x), nearest)))) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
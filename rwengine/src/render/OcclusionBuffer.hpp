@@ -0,0 +1,109 @@
+#ifndef _RWENGINE_OCCLUSIONBUFFER_HPP_
+#define _RWENGINE_OCCLUSIONBUFFER_HPP_
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Low resolution software depth buffer for occlusion culling
+ *
+ * Boxes that are known to be solid, such as the collision boxes of nearby
+ * buildings, are rasterized with the view projection. Bounds can then be
+ * tested against the result, they are hidden if every pixel they cover
+ * holds something nearer than their nearest point.
+ *
+ * Boxes that cross the near plane are dropped, and bounds that do are
+ * always visible, so no clipping is needed. Pixels are written by four at a
+ * time using SSE2 or NEON where available.
+ *
+ * Rasterizing disjoint row ranges, and testing, are safe to do from
+ * several threads at once. Adding boxes is not.
+ */
+class OcclusionBuffer {
+public:
+    /**
+     * @param width Rounded up to a multiple of 4
+     */
+    OcclusionBuffer(int width = 256, int height = 128);
+
+    /**
+     * @brief Removes every occluder and starts a frame viewed through
+     * viewProjection
+     */
+    void clear(const glm::mat4& viewProjection);
+
+    /**
+     * @brief Queues a solid box in model space to be rasterized
+     */
+    void addBox(const glm::mat4& model, const glm::vec3& min,
+                const glm::vec3& max);
+
+    /**
+     * @brief Rasterizes the queued boxes into the rows [begin, end)
+     */
+    void rasterize(int begin, int end);
+
+    void rasterize() {
+        rasterize(0, m_height);
+    }
+
+    /**
+     * @return false if the world space box is certainly hidden
+     */
+    bool isVisible(const glm::vec3& min, const glm::vec3& max) const;
+
+    bool isVisible(const glm::vec3& center, float radius) const {
+        return isVisible(center - glm::vec3(radius),
+                         center + glm::vec3(radius));
+    }
+
+    size_t getTriangleCount() const {
+        return m_triangles.size();
+    }
+
+    int getWidth() const {
+        return m_width;
+    }
+
+    int getHeight() const {
+        return m_height;
+    }
+
+    /**
+     * @return Window space depth at the pixel, larger than 1 if empty
+     */
+    float getDepth(int x, int y) const {
+        return m_depth[y * m_width + x];
+    }
+
+private:
+    /// A triangle as edge functions and a depth plane in pixel space
+    struct Triangle {
+        /// Edge i is inside where x * a + y * b + c >= 0
+        float a[3], b[3], c[3];
+        /// Depth is x * dzdx + y * dzdy + z0
+        float dzdx, dzdy, z0;
+        /// Pixel bounds, the maximums are exclusive
+        int minX, minY, maxX, maxY;
+    };
+
+    int m_width;
+    int m_height;
+    glm::mat4 m_viewProjection;
+    std::vector<float> m_depth;
+    std::vector<Triangle> m_triangles;
+
+    /**
+     * @brief Projects a world space point to x, y in pixels and window
+     * depth
+     * @return false if the point is behind the near plane
+     */
+    bool project(const glm::vec4& world, glm::vec3& out) const;
+
+    void addTriangle(const glm::vec3& v0, const glm::vec3& v1,
+                     const glm::vec3& v2);
+};
+
+#endif
@@ -91,6 +91,8 @@ void Renderer::swap() {
     drawCounter = 0;
     textureCounter = 0;
     bufferCounter = 0;
+    avoidedTextureCounter = 0;
+    avoidedBufferCounter = 0;
 }
 
 int Renderer::getDrawCount() {
@@ -105,6 +107,14 @@ int Renderer::getTextureCount() {
     return textureCounter;
 }
 
+int Renderer::getAvoidedTextureCount() {
+    return avoidedTextureCounter;
+}
+
+int Renderer::getAvoidedBufferCount() {
+    return avoidedBufferCounter;
+}
+
 const Renderer::SceneUniformData& Renderer::getSceneData() const {
     return lastSceneData;
 }
@@ -119,6 +129,8 @@ void OpenGLRenderer::useDrawBuffer(DrawBuffer* dbuff) {
             profileInfo[currentDebugDepth - 1].buffers++;
         }
 #endif
+    } else {
+        avoidedBufferCounter++;
     }
 }
 
@@ -133,6 +145,26 @@ void OpenGLRenderer::useTexture(GLuint unit, GLuint tex) {
             profileInfo[currentDebugDepth - 1].textures++;
         }
 #endif
+    } else {
+        avoidedTextureCounter++;
+    }
+}
+
+void OpenGLRenderer::useTextureArray(GLuint tex) {
+    if (currentTextureArray != tex) {
+        glActiveTexture(GL_TEXTURE0 + kTextureArrayUnit);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, tex);
+        // Code binding textures directly expects the first unit to be active
+        glActiveTexture(GL_TEXTURE0);
+        currentTextureArray = tex;
+        textureCounter++;
+#if RW_PROFILER
+        if (currentDebugDepth > 0) {
+            profileInfo[currentDebugDepth - 1].textures++;
+        }
+#endif
+    } else {
+        avoidedTextureCounter++;
     }
 }
 
@@ -143,39 +175,21 @@ void OpenGLRenderer::useProgram(Renderer::ShaderProgram* p) {
     }
 }
 
-#if 0
-template<>
-void OpenGLRenderer::uploadUBO<OpenGLRenderer::ObjectUniformData>(GLuint buffer, const ObjectUniformData& data)
-{
-	if( currentUBO != buffer ) {
-		glBindBuffer(GL_UNIFORM_BUFFER, buffer);
-		currentUBO = buffer;
-	}
-	/*glBindBufferRange(GL_UNIFORM_BUFFER,
-					  2,
-					  UBOObject,
-					  entryAlignment * currentObjectEntry,
-					  sizeof(ObjectUniformData));*/
-	glBufferSubData(GL_UNIFORM_BUFFER,
-					0,
-					sizeof(ObjectUniformData), &data);
-#if RW_PROFILER
-	if( currentDebugDepth > 0 )
-	{
-		profileInfo[currentDebugDepth-1].uploads++;
-	}
-#endif
-	currentObjectEntry = (currentObjectEntry+1) % maxObjectEntries;
+constexpr GLuint Renderer::kTextureArrayUnit;
+constexpr GLuint OpenGLRenderer::kMaxInstances;
+
+namespace {
+/// Uniform binding point of the ObjectData block
+constexpr GLuint kObjectDataBinding = 2;
+/// Bytes of ObjectData each region of the ring can hold
+constexpr GLsizeiptr kObjectRingRegionSize = 4 * 1024 * 1024;
 }
-#endif
 
 OpenGLRenderer::OpenGLRenderer()
     : currentDbuff(nullptr)
+    , currentTextureArray(0)
     , currentProgram(nullptr)
     , currentUBO(0)
-    , maxObjectEntries(0)
-    , currentObjectEntry(0)
-    , entryAlignment(0)
     , blendEnabled(false)
     , depthWriteEnabled(true)
     , currentDebugDepth(0) {
@@ -183,25 +197,27 @@ OpenGLRenderer::OpenGLRenderer()
     ogl_CheckExtensions();
 
     glGenBuffers(1, &UBOScene);
-    glGenBuffers(1, &UBOObject);
 
     glBindBufferBase(GL_UNIFORM_BUFFER, 1, UBOScene);
-    glBindBufferBase(GL_UNIFORM_BUFFER, 2, UBOObject);
+
+    // Every binding must cover the whole ObjectData block
+    objectRing.reset(new UniformRing(
+        kObjectRingRegionSize, sizeof(ObjectUniformData) * kMaxInstances));
+    currentUBO = objectRing->getName();
 
     swap();
 
+    // GL guarantees blocks of at least 16KB, enough for every instance
     GLint maxUBOSize, UBOAlignment;
     glGetIntegerv(GL_MAX_UNIFORM_BLOCK_SIZE, &maxUBOSize);
     glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &UBOAlignment);
-    entryAlignment = 128;
-    maxObjectEntries = maxUBOSize / entryAlignment;
     std::cout << "Max UBO Size: " << maxUBOSize << std::endl;
     std::cout << "UBO Alignment: " << UBOAlignment << std::endl;
-    std::cout << "Max batch size: " << maxObjectEntries << std::endl;
+    std::cout << "Max batch size: " << kMaxInstances << std::endl;
+    std::cout << "Persistent uniform ring: "
+              << (objectRing->isPersistent() ? "yes" : "no") << std::endl;
 
-    glBindBuffer(GL_UNIFORM_BUFFER, UBOObject);
-    glBufferData(GL_UNIFORM_BUFFER, entryAlignment * maxObjectEntries, NULL,
-                 GL_STREAM_DRAW);
+    instanceData.reserve(kMaxInstances);
 
     glGenQueries(1, &debugQuery);
 }
@@ -301,32 +317,75 @@ void OpenGLRenderer::setSceneParameters(
     lastSceneData = data;
 }
 
-void OpenGLRenderer::setDrawState(const glm::mat4& model, DrawBuffer* draw,
-                                  const Renderer::DrawParameters& p) {
+void OpenGLRenderer::useDrawState(DrawBuffer* draw,
+                                  const Renderer::DrawParameters& p,
+                                  GLuint instances) {
     useDrawBuffer(draw);
 
-    for (GLuint u = 0; u < p.textures.size(); ++u) {
-        useTexture(u, p.textures[u]);
+    if (p.textureLayer >= 0) {
+        // The layer is sampled from the array unit, so the 2D units are
+        // left as they are
+        useTextureArray(p.textures[0]);
+    } else {
+        for (GLuint u = 0; u < p.textures.size(); ++u) {
+            useTexture(u, p.textures[u]);
+        }
     }
 
     setBlend(p.blend);
     setDepthWrite(p.depthWrite);
 
-    ObjectUniformData oudata{model,
-                             glm::vec4(p.colour.r / 255.f, p.colour.g / 255.f,
-                                       p.colour.b / 255.f, p.colour.a / 255.f),
-                             1.f, 1.f, p.visibility};
-    uploadUBO(UBOObject, oudata);
-
     drawCounter++;
 #if RW_PROFILER
     if (currentDebugDepth > 0) {
         profileInfo[currentDebugDepth - 1].draws++;
-        profileInfo[currentDebugDepth - 1].primitives += p.count;
+        profileInfo[currentDebugDepth - 1].primitives += p.count * instances;
     }
+#else
+    RW_UNUSED(instances);
 #endif
 }
 
+void OpenGLRenderer::uploadObjects(const ObjectUniformData* objects,
+                                   GLuint count) {
+    objectRing->upload(kObjectDataBinding, objects,
+                       sizeof(ObjectUniformData) * count);
+    // The ring leaves its buffer bound
+    currentUBO = objectRing->getName();
+#if RW_PROFILER
+    if (currentDebugDepth > 0) {
+        profileInfo[currentDebugDepth - 1].uploads++;
+    }
+#endif
+}
+
+OpenGLRenderer::ObjectUniformData OpenGLRenderer::makeObjectData(
+    const glm::mat4& model, const Renderer::DrawParameters& p) {
+    return {model,
+            glm::vec4(p.colour.r / 255.f, p.colour.g / 255.f,
+                      p.colour.b / 255.f, p.colour.a / 255.f),
+            1.f, 1.f, p.visibility, float(p.textureLayer)};
+}
+
+bool OpenGLRenderer::canInstance(const RenderInstruction& a,
+                                 const RenderInstruction& b) {
+    // Instances can use different layers of the same array, the layer is
+    // part of each one's object parameters
+    return a.dbuff == b.dbuff && a.drawInfo.start == b.drawInfo.start &&
+           a.drawInfo.count == b.drawInfo.count &&
+           a.drawInfo.blend == b.drawInfo.blend &&
+           a.drawInfo.depthWrite == b.drawInfo.depthWrite &&
+           a.drawInfo.textures == b.drawInfo.textures;
+}
+
+void OpenGLRenderer::setDrawState(const glm::mat4& model, DrawBuffer* draw,
+                                  const Renderer::DrawParameters& p) {
+    useDrawState(draw, p, 1);
+
+    auto object = makeObjectData(model, p);
+    uploadObjects(&object, 1);
+}
+
 void OpenGLRenderer::draw(const glm::mat4& model, DrawBuffer* draw,
                           const Renderer::DrawParameters& p) {
     setDrawState(model, draw, p);
@@ -342,63 +401,59 @@ void OpenGLRenderer::drawArrays(const glm::mat4& model, DrawBuffer* draw,
     glDrawArrays(draw->getFaceType(), p.start, p.count);
 }
 
-void OpenGLRenderer::drawBatched(const RenderList& list) {
-#if 0  // Needs shader changes
-	// Determine how many batches we need to process the entire list
-	auto entries = list.size();
-	glBindBuffer(GL_UNIFORM_BUFFER, UBOObject);
-	for (int b = 0; b < entries; b += maxObjectEntries)
-	{
-		auto toConsume = std::min((GLuint)entries, b + maxObjectEntries) - b;
-		std::vector<ObjectUniformData> uploadBuffer;
-		uploadBuffer.resize(toConsume);
-		for (int d = 0; d < toConsume; ++d)
-		{
-			auto& draw = list[b+d];
-			uploadBuffer[d] = {
-				draw.model,
-				glm::vec4(draw.drawInfo.colour.r/255.f,
-				draw.drawInfo.colour.g/255.f,
-				draw.drawInfo.colour.b/255.f, 1.f),
-				1.f,
-				1.f,
-				draw.drawInfo.colour.a/255.f
-			};
-		}
-		glBufferData(GL_UNIFORM_BUFFER,
-					 toConsume * sizeof(ObjectUniformData),
-					 uploadBuffer.data(),
-					 GL_STREAM_DRAW);
-
-		// Dispatch individual draws
-		for (int d = 0; d < toConsume; ++d)
-		{
-			auto& draw = list[b+d];
-			useDrawBuffer(draw.dbuff);
-
-			for( GLuint u = 0; u < draw.drawInfo.textures.size(); ++u )
-			{
-				useTexture(u, draw.drawInfo.textures[u]);
-			}
-
-			glDrawElements(draw.dbuff->getFaceType(), draw.drawInfo.count, GL_UNSIGNED_INT,
-						   (void*) (sizeof(RenderIndex) * draw.drawInfo.start));
-		}
-	}
-#else
-    for (auto& ri : list) {
-        draw(ri.model, ri.dbuff, ri.drawInfo);
+void OpenGLRenderer::drawBatched(const RenderList& list,
+                                 const RenderOrder& order) {
+    for (size_t i = 0; i < order.size();) {
+        auto& first = list[order[i]];
+
+        // Gather the following instructions that draw the same thing with
+        // the same state, they only differ by their object parameters.
+        size_t end = i + 1;
+        while (end < order.size() && end - i < kMaxInstances &&
+               canInstance(first, list[order[end]])) {
+            ++end;
+        }
+
+        if (end - i == 1) {
+            draw(list.getTransform(first), first.dbuff, first.drawInfo);
+            i = end;
+            continue;
+        }
+
+        instanceData.clear();
+        for (size_t d = i; d < end; ++d) {
+            auto& ri = list[order[d]];
+            instanceData.push_back(
+                makeObjectData(list.getTransform(ri), ri.drawInfo));
+        }
+
+        auto instances = static_cast<GLuint>(instanceData.size());
+        useDrawState(first.dbuff, first.drawInfo, instances);
+        uploadObjects(instanceData.data(), instances);
+
+        glDrawElementsInstanced(
+            first.dbuff->getFaceType(), first.drawInfo.count, GL_UNSIGNED_INT,
+            (void*)(sizeof(RenderIndex) * first.drawInfo.start), instances);
+
+        i = end;
     }
-#endif
 }
 
 void OpenGLRenderer::invalidate() {
     currentDbuff = nullptr;
     currentProgram = nullptr;
     currentTextures.clear();
+    currentTextureArray = 0;
     currentUBO = 0;
 }
 
+void OpenGLRenderer::swap() {
+    Renderer::swap();
+
+    // Start writing where the last frame's draws can't be reading
+    objectRing->nextFrame();
+}
+
 void OpenGLRenderer::pushDebugGroup(const std::string& title) {
 #if RW_PROFILER
     if (ogl_ext_KHR_debug) {
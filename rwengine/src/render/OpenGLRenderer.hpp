@@ -2,10 +2,16 @@
 #ifndef _OPENGLRENDERER_HPP_
 #define _OPENGLRENDERER_HPP_
 
+#include <algorithm>
 #include <gl/DrawBuffer.hpp>
 #include <gl/GeometryBuffer.hpp>
 #include <glm/vec2.hpp>
+#include <initializer_list>
+#include <memory>
+#include <rw/defines.hpp>
+#include <render/UniformRing.hpp>
 #include <rw/types.hpp>
+#include <vector>
 
 typedef uint64_t RenderKey;
 
@@ -35,7 +41,50 @@ struct VertexP2 {
 
 class Renderer {
 public:
-    typedef std::vector<GLuint> Textures;
+    /**
+     * @brief The texture bound to each texture unit for a draw
+     *
+     * Stored inline, so that building draw lists doesn't allocate.
+     */
+    class Textures {
+    public:
+        static constexpr size_t kMaxTextures = 2;
+
+        Textures() : m_textures{}, m_count(0) {
+        }
+
+        Textures(std::initializer_list<GLuint> textures)
+            : m_textures{}, m_count(0) {
+            RW_CHECK(textures.size() <= kMaxTextures, "Too many textures");
+            for (auto texture : textures) {
+                if (m_count == kMaxTextures) {
+                    break;
+                }
+                m_textures[m_count++] = texture;
+            }
+        }
+
+        size_t size() const {
+            return m_count;
+        }
+
+        GLuint operator[](size_t unit) const {
+            return m_textures[unit];
+        }
+
+        bool operator==(const Textures& other) const {
+            return m_count == other.m_count &&
+                   std::equal(m_textures, m_textures + m_count,
+                              other.m_textures);
+        }
+
+    private:
+        GLuint m_textures[kMaxTextures];
+        uint8_t m_count;
+    };
+
+    /// The texture unit array textures are bound to, after those of Textures
+    static constexpr GLuint kTextureArrayUnit = Textures::kMaxTextures;
 
     /**
      * @brief The DrawParameters struct stores drawing state
@@ -48,7 +97,7 @@ public:
      */
     struct DrawParameters {
         /// Number of indicies
-        size_t count;
+        unsigned int count;
         /// Start index.
         unsigned int start;
         /// Textures to use
@@ -57,6 +106,8 @@ public:
         bool blend;
         // Depth writing state
         bool depthWrite;
+        /// Layer of textures[0] if it is an array texture, otherwise -1
+        int16_t textureLayer;
         /// Material
         glm::u8vec4 colour;
         /// Material
@@ -70,6 +121,7 @@ public:
         DrawParameters()
             : blend(false)
             , depthWrite(true)
+            , textureLayer(-1)
             , ambient(1.f)
             , diffuse(1.f)
             , visibility(1.f) {
@@ -84,25 +136,82 @@ public:
      */
     struct RenderInstruction {
         RenderKey sortKey;
-        // Ideally, this would just be an index into a buffer that contains the
-        // matrix
-        glm::mat4 model;
+        /// Index of the model matrix in the RenderList's transforms
+        uint32_t transform;
         DrawBuffer* dbuff;
         Renderer::DrawParameters drawInfo;
 
-        RenderInstruction(RenderKey key, const glm::mat4& model,
-                          DrawBuffer* dbuff, const Renderer::DrawParameters& dp)
-            : sortKey(key), model(model), dbuff(dbuff), drawInfo(dp) {
+        RenderInstruction(RenderKey key, uint32_t transform, DrawBuffer* dbuff,
+                          const Renderer::DrawParameters& dp)
+            : sortKey(key), transform(transform), dbuff(dbuff), drawInfo(dp) {
+        }
+    };
+
+    /**
+     * @brief RenderInstructions and the model matrices they use
+     *
+     * Instructions refer to their matrix by index, so that the parts of a
+     * geometry share one matrix and instructions stay cheap to copy.
+     */
+    struct RenderList {
+        std::vector<RenderInstruction> instructions;
+        std::vector<glm::mat4> transforms;
+
+        /**
+         * @return The index to give instructions using model
+         */
+        uint32_t addTransform(const glm::mat4& model) {
+            transforms.push_back(model);
+            return static_cast<uint32_t>(transforms.size() - 1);
+        }
+
+        void addInstruction(RenderKey key, uint32_t transform,
+                            DrawBuffer* dbuff,
+                            const Renderer::DrawParameters& dp) {
+            instructions.emplace_back(key, transform, dbuff, dp);
+        }
+
+        /**
+         * @brief Appends the contents of other, keeping their transforms
+         */
+        void append(const RenderList& other) {
+            auto base = static_cast<uint32_t>(transforms.size());
+            transforms.insert(transforms.end(), other.transforms.begin(),
+                              other.transforms.end());
+            for (auto& instruction : other.instructions) {
+                instructions.push_back(instruction);
+                instructions.back().transform += base;
+            }
+        }
+
+        const glm::mat4& getTransform(const RenderInstruction& ri) const {
+            return transforms[ri.transform];
+        }
+
+        const RenderInstruction& operator[](size_t i) const {
+            return instructions[i];
+        }
+
+        size_t size() const {
+            return instructions.size();
+        }
+
+        void clear() {
+            instructions.clear();
+            transforms.clear();
         }
     };
-    typedef std::vector<RenderInstruction> RenderList;
+    /// Indices into a RenderList, in the order they should be drawn
+    typedef std::vector<uint32_t> RenderOrder;
 
+    /// Per object parameters, laid out as an element of a std140 array
     struct ObjectUniformData {
         glm::mat4 model;
         glm::vec4 colour;
         float diffuse;
         float ambient;
         float visibility;
+        float layer;
     };
 
     struct SceneUniformData {
@@ -154,7 +263,11 @@ public:
     virtual void drawArrays(const glm::mat4& model, DrawBuffer* draw,
                             const DrawParameters& p) = 0;
 
-    virtual void drawBatched(const RenderList& list) = 0;
+    /**
+     * @brief Draws the instructions of list in the given order
+     */
+    virtual void drawBatched(const RenderList& list,
+                             const RenderOrder& order) = 0;
 
     void setViewport(const glm::ivec2& vp);
     const glm::ivec2& getViewport() const {
@@ -170,7 +283,7 @@ public:
     /**
      * Resets all per-frame counters.
      */
-    void swap();
+    virtual void swap();
 
     /**
      * Returns the number of draw calls issued for the current frame.
@@ -179,6 +292,13 @@ public:
     int getTextureCount();
     int getBufferCount();
 
+    /**
+     * Returns the number of texture and buffer binds skipped for the
+     * current frame, because the state was already set.
+     */
+    int getAvoidedTextureCount();
+    int getAvoidedBufferCount();
+
     const SceneUniformData& getSceneData() const;
 
     /**
@@ -215,6 +335,8 @@ protected:
     int drawCounter;
     int textureCounter;
     int bufferCounter;
+    int avoidedTextureCounter;
+    int avoidedBufferCounter;
     SceneUniformData lastSceneData;
 };
 
@@ -272,6 +394,9 @@ public:
 
     void setSceneParameters(const SceneUniformData& data) override;
 
+    /// Instances per draw, the size of the ObjectData array in the shaders
+    static constexpr GLuint kMaxInstances = 128;
+
     void setDrawState(const glm::mat4& model, DrawBuffer* draw,
                       const DrawParameters& p);
 
@@ -280,10 +405,12 @@ public:
     void drawArrays(const glm::mat4& model, DrawBuffer* draw,
                     const DrawParameters& p) override;
 
-    void drawBatched(const RenderList& list) override;
+    void drawBatched(const RenderList& list, const RenderOrder& order) override;
 
     void invalidate() override;
 
+    void swap() override;
+
     virtual void pushDebugGroup(const std::string& title) override;
     virtual const ProfileInfo& popDebugGroup() override;
 
@@ -295,6 +422,9 @@ private:
     std::map<GLuint, GLuint> currentTextures;
     void useTexture(GLuint unit, GLuint tex);
 
+    GLuint currentTextureArray;
+    void useTextureArray(GLuint tex);
+
     OpenGLShaderProgram* currentProgram;
 
     GLuint currentUBO;
@@ -312,12 +442,34 @@ private:
 #endif
     }
 
-    GLuint UBOObject;
-    GLuint maxObjectEntries;
-    GLuint currentObjectEntry;
-    GLuint entryAlignment;
     GLuint UBOScene;
 
+    /// Holds the ObjectData for every draw
+    std::unique_ptr<UniformRing> objectRing;
+
+    /// Parameters for each instance of the current instanced draw
+    std::vector<ObjectUniformData> instanceData;
+
+    /**
+     * Binds the buffer, textures and render state for a draw, and counts it
+     */
+    void useDrawState(DrawBuffer* draw, const DrawParameters& p,
+                      GLuint instances);
+
+    /**
+     * Streams objects into the ring and binds them as the ObjectData
+     */
+    void uploadObjects(const ObjectUniformData* objects, GLuint count);
+
+    static ObjectUniformData makeObjectData(const glm::mat4& model,
+                                            const DrawParameters& p);
+
+    /**
+     * @return If b can be drawn as another instance of a
+     */
+    static bool canInstance(const RenderInstruction& a,
+                            const RenderInstruction& b);
+
     // State Cache
     bool blendEnabled;
     bool depthWriteEnabled;
@@ -359,5 +511,6 @@ GLuint compileShader(GLenum type, const char* source);
 GLuint compileProgram(const char* vertex, const char* fragment);
 
 typedef Renderer::RenderList RenderList;
+typedef Renderer::RenderOrder RenderOrder;
 
 #endif
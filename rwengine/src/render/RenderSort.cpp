@@ -0,0 +1,92 @@
+#include <render/RenderSort.hpp>
+
+#include <algorithm>
+
+namespace {
+/// Bits sorted per pass
+constexpr unsigned kRadixBits = 8;
+constexpr size_t kRadixSize = 1 << kRadixBits;
+constexpr unsigned kRadixPasses = sizeof(RenderKey) * 8 / kRadixBits;
+}
+
+const RenderOrder& RenderSorter::sort(const RenderList& list) {
+    m_entries.resize(list.size());
+    for (size_t i = 0; i < list.size(); ++i) {
+        m_entries[i] = {list[i].sortKey, static_cast<uint32_t>(i)};
+    }
+
+    sortEntries(m_entries, m_scratch);
+
+    m_order.resize(m_entries.size());
+    for (size_t i = 0; i < m_entries.size(); ++i) {
+        m_order[i] = m_entries[i].index;
+    }
+    return m_order;
+}
+
+const RenderOrder& RenderSorter::sort(const RenderList& list,
+                                      const RenderOrder& sorted) {
+    auto first = sorted.size();
+    m_entries.resize(list.size() - first);
+    for (size_t i = first; i < list.size(); ++i) {
+        m_entries[i - first] = {list[i].sortKey, static_cast<uint32_t>(i)};
+    }
+
+    sortEntries(m_entries, m_scratch);
+
+    // Sorted instructions come first in the list, so they win ties to keep
+    // the merge stable
+    m_order.resize(list.size());
+    size_t a = 0, b = 0, out = 0;
+    while (a < sorted.size() && b < m_entries.size()) {
+        if (m_entries[b].key < list[sorted[a]].sortKey) {
+            m_order[out++] = m_entries[b++].index;
+        } else {
+            m_order[out++] = sorted[a++];
+        }
+    }
+    while (a < sorted.size()) {
+        m_order[out++] = sorted[a++];
+    }
+    while (b < m_entries.size()) {
+        m_order[out++] = m_entries[b++].index;
+    }
+    return m_order;
+}
+
+void RenderSorter::sortEntries(std::vector<Entry>& entries,
+                               std::vector<Entry>& scratch) {
+    // Count every digit up front, it only takes one read of the keys
+    size_t counts[kRadixPasses][kRadixSize] = {};
+    for (auto& entry : entries) {
+        for (unsigned p = 0; p < kRadixPasses; ++p) {
+            counts[p][(entry.key >> (p * kRadixBits)) & (kRadixSize - 1)]++;
+        }
+    }
+
+    scratch.resize(entries.size());
+    for (unsigned p = 0; p < kRadixPasses; ++p) {
+        auto& count = counts[p];
+        auto shift = p * kRadixBits;
+
+        // Keys only use some of their bits, skip the passes where every key
+        // has the same digit.
+        if (entries.empty() ||
+            count[(entries[0].key >> shift) & (kRadixSize - 1)] ==
+                entries.size()) {
+            continue;
+        }
+
+        size_t offset = 0;
+        for (auto& c : count) {
+            auto n = c;
+            c = offset;
+            offset += n;
+        }
+
+        for (auto& entry : entries) {
+            scratch[count[(entry.key >> shift) & (kRadixSize - 1)]++] = entry;
+        }
+        entries.swap(scratch);
+    }
+}
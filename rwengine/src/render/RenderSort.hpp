@@ -0,0 +1,119 @@
+#ifndef _RWENGINE_RENDERSORT_HPP_
+#define _RWENGINE_RENDERSORT_HPP_
+
+#include <render/OpenGLRenderer.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Describes how the state of a draw is packed into a RenderKey
+ *
+ * Keys sort ascending. Opaque draws come first, grouped by vertex array,
+ * then by texture, then ordered front to back by a coarse depth. This keeps
+ * buffer and texture changes rare while nearby geometry still fills the
+ * depth buffer early. Translucent draws follow, strictly back to front.
+ *
+ * Each field keeps the low bits of its value. Names that collide only cost
+ * extra state changes. The translucency flag sits just above the widest
+ * layout, so the unused high bits cost no sorting passes.
+ */
+struct RenderKeyLayout {
+    unsigned bufferBits = 16;
+    unsigned textureBits = 16;
+    unsigned depthBits = 12;
+    unsigned translucentDepthBits = 24;
+
+    /**
+     * @param depth Distance into the view, 0 at the near plane and 1 at far
+     */
+    RenderKey opaque(GLuint buffer, GLuint texture, float depth) const {
+        return field(buffer, bufferBits) << (textureBits + depthBits) |
+               field(texture, textureBits) << depthBits |
+               quantize(depth, depthBits);
+    }
+
+    /**
+     * @param depth Distance into the view, 0 at the near plane and 1 at far
+     */
+    RenderKey translucent(GLuint texture, float depth) const {
+        return RenderKey(1) << translucentShift() |
+               quantize(1.f - depth, translucentDepthBits) << textureBits |
+               field(texture, textureBits);
+    }
+
+    /**
+     * @return If every key fits in a RenderKey
+     */
+    bool isValid() const {
+        return translucentShift() < sizeof(RenderKey) * 8;
+    }
+
+private:
+    unsigned translucentShift() const {
+        return std::max(bufferBits + textureBits + depthBits,
+                        translucentDepthBits + textureBits);
+    }
+
+    static RenderKey mask(unsigned bits) {
+        return bits >= 64 ? ~RenderKey(0) : (RenderKey(1) << bits) - 1;
+    }
+
+    static RenderKey field(RenderKey value, unsigned bits) {
+        return value & mask(bits);
+    }
+
+    static RenderKey quantize(float value, unsigned bits) {
+        // Written so that NaN ends up at 0
+        if (!(value > 0.f)) {
+            return 0;
+        }
+        if (value >= 1.f) {
+            return mask(bits);
+        }
+        return RenderKey(double(value) * double(mask(bits)));
+    }
+};
+
+/**
+ * @brief Orders render lists by their RenderKeys
+ *
+ * Instead of moving the RenderInstructions around, a compact array
+ * of keys and list indices is sorted with an LSD radix sort, and the
+ * resulting index order is handed to Renderer::drawBatched.
+ *
+ * The sort is stable, and its buffers are kept between frames.
+ */
+class RenderSorter {
+public:
+    struct Entry {
+        RenderKey key;
+        uint32_t index;
+    };
+
+    /**
+     * @return The indices of list's instructions, ordered by sortKey
+     */
+    const RenderOrder& sort(const RenderList& list);
+
+    /**
+     * @brief Sorts the instructions following those already ordered by
+     * sorted, and merges the two
+     * @return The same order sort(list) gives
+     */
+    const RenderOrder& sort(const RenderList& list, const RenderOrder& sorted);
+
+    /**
+     * @brief Sorts entries by key, using scratch as the second buffer
+     */
+    static void sortEntries(std::vector<Entry>& entries,
+                            std::vector<Entry>& scratch);
+
+private:
+    std::vector<Entry> m_entries;
+    std::vector<Entry> m_scratch;
+    RenderOrder m_order;
+};
+
+#endif
@@ -0,0 +1,306 @@
+#include <render/StaticInstanceTree.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <data/Model.hpp>
+#include <data/ModelData.hpp>
+#include <objects/InstanceObject.hpp>
+#include <render/OcclusionBuffer.hpp>
+
+namespace {
+/// Items per leaf, small leaves waste nodes, large ones cost sphere tests
+constexpr uint32_t kLeafSize = 8;
+
+/// Furthest a frame's geometry can reach from the model origin
+float frameRadius(Model* model, ModelFrame* frame, float offset) {
+    offset += glm::length(glm::vec3(frame->getTransform()[3]));
+
+    float radius = 0.f;
+    for (size_t g : frame->getGeometries()) {
+        auto& bounds = model->geometries[g]->geometryBounds;
+        radius = std::max(radius,
+                          offset + glm::length(bounds.center) + bounds.radius);
+    }
+    for (ModelFrame* child : frame->getChildren()) {
+        radius = std::max(radius, frameRadius(model, child, offset));
+    }
+    return radius;
+}
+
+/// Models may not be streamed in yet, so the collision bounds are used too
+float modelRadius(InstanceObject* instance) {
+    float radius = 0.f;
+    auto info = instance->getModelInfo<BaseModelInfo>();
+    auto collision = info ? info->getCollision() : nullptr;
+    if (collision) {
+        auto& sphere = collision->boundingSphere;
+        radius = glm::length(sphere.center) + sphere.radius;
+    }
+
+    auto model = instance->getModel();
+    if (model && !model->frames.empty()) {
+        radius = std::max(radius, frameRadius(model, model->frames[0], 0.f));
+    }
+    return radius;
+}
+}
+
+void StaticInstanceTree::insert(InstanceObject* instance) {
+    if (instance->staticInstance) {
+        return;
+    }
+    instance->staticInstance = true;
+    m_items.push_back({glm::vec3(), 0.f, instance, 0});
+    m_dirty = true;
+}
+
+void StaticInstanceTree::remove(InstanceObject* instance) {
+    if (!instance->staticInstance) {
+        return;
+    }
+    instance->staticInstance = false;
+    m_items.erase(std::remove_if(m_items.begin(), m_items.end(),
+                                 [&](const Item& item) {
+                                     return item.instance == instance;
+                                 }),
+                  m_items.end());
+    m_dirty = true;
+}
+
+bool StaticInstanceTree::contains(GameObject* object) {
+    return object->type() == GameObject::Instance &&
+           static_cast<InstanceObject*>(object)->staticInstance;
+}
+
+float StaticInstanceTree::getCullingRadius(InstanceObject* instance) {
+    float radius = modelRadius(instance);
+
+    // The LOD model is drawn in place of the instance, from its own position
+    auto lod = instance->LODinstance;
+    if (lod) {
+        auto offset = glm::length(lod->getPosition() - instance->getPosition());
+        radius = std::max(radius, offset + modelRadius(lod));
+    }
+
+    return radius;
+}
+
+void StaticInstanceTree::build() {
+    for (auto& item : m_items) {
+        item.center = item.instance->getPosition();
+        item.radius = getCullingRadius(item.instance);
+    }
+
+    m_nodes.clear();
+    m_parents.clear();
+    if (!m_items.empty()) {
+        m_nodes.reserve(2 * (m_items.size() / kLeafSize + 1));
+        m_parents.reserve(m_nodes.capacity());
+        buildNode(0, static_cast<uint32_t>(m_items.size()));
+    }
+
+    m_spheres.clear();
+    m_dependents.clear();
+    for (uint32_t i = 0; i < m_items.size(); ++i) {
+        auto& item = m_items[i];
+        m_spheres.add(item.center, item.radius);
+        m_dependents.emplace(item.instance, i);
+        if (item.instance->LODinstance) {
+            m_dependents.emplace(item.instance->LODinstance, i);
+        }
+    }
+
+    m_dirty = false;
+    m_stale.clear();
+}
+
+void StaticInstanceTree::updateBounds(InstanceObject* instance) {
+    // A rebuild recomputes every item anyway
+    if (m_dirty) {
+        return;
+    }
+    auto range = m_dependents.equal_range(instance);
+    for (auto it = range.first; it != range.second; ++it) {
+        m_stale.push_back(it->second);
+    }
+}
+
+void StaticInstanceTree::refit() {
+    // An item may be stale through both its own model and its LOD's
+    std::sort(m_stale.begin(), m_stale.end());
+    m_stale.erase(std::unique(m_stale.begin(), m_stale.end()), m_stale.end());
+
+    std::vector<uint32_t> nodes;
+    for (auto i : m_stale) {
+        auto& item = m_items[i];
+        item.radius = getCullingRadius(item.instance);
+        m_spheres.radius[i] = item.radius;
+        for (auto node = item.leaf;; node = m_parents[node]) {
+            nodes.push_back(node);
+            if (node == 0) {
+                break;
+            }
+        }
+    }
+    m_stale.clear();
+
+    // Children always follow their parent, so they're refit first
+    std::sort(nodes.begin(), nodes.end(), std::greater<uint32_t>());
+    nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+    for (auto node : nodes) {
+        fitNode(node);
+    }
+}
+
+void StaticInstanceTree::fitNode(uint32_t index) {
+    auto& node = m_nodes[index];
+    if (node.count > 0) {
+        node.min = glm::vec3(std::numeric_limits<float>::max());
+        node.max = glm::vec3(-std::numeric_limits<float>::max());
+        for (auto i = node.index; i < node.index + node.count; ++i) {
+            auto& item = m_items[i];
+            node.min = glm::min(node.min, item.center - glm::vec3(item.radius));
+            node.max = glm::max(node.max, item.center + glm::vec3(item.radius));
+        }
+    } else {
+        auto& first = m_nodes[index + 1];
+        auto& second = m_nodes[node.index];
+        node.min = glm::min(first.min, second.min);
+        node.max = glm::max(first.max, second.max);
+    }
+}
+
+uint32_t StaticInstanceTree::buildNode(uint32_t first, uint32_t count) {
+    auto index = static_cast<uint32_t>(m_nodes.size());
+    m_nodes.push_back({});
+    m_parents.push_back(index);
+
+    glm::vec3 min(std::numeric_limits<float>::max());
+    glm::vec3 max(-std::numeric_limits<float>::max());
+    glm::vec3 centerMin = min, centerMax = max;
+    for (auto i = first; i < first + count; ++i) {
+        auto& item = m_items[i];
+        min = glm::min(min, item.center - glm::vec3(item.radius));
+        max = glm::max(max, item.center + glm::vec3(item.radius));
+        centerMin = glm::min(centerMin, item.center);
+        centerMax = glm::max(centerMax, item.center);
+    }
+
+    if (count <= kLeafSize) {
+        m_nodes[index] = {min, max, first, count};
+        for (auto i = first; i < first + count; ++i) {
+            m_items[i].leaf = index;
+        }
+        return index;
+    }
+
+    // Split at the median along the axis the centers are most spread over
+    auto extent = centerMax - centerMin;
+    int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2)
+                                   : (extent.y > extent.z ? 1 : 2);
+    auto half = count / 2;
+    std::nth_element(m_items.begin() + first, m_items.begin() + first + half,
+                     m_items.begin() + first + count,
+                     [axis](const Item& a, const Item& b) {
+                         return a.center[axis] < b.center[axis];
+                     });
+
+    m_parents[buildNode(first, half)] = index;
+    auto second = buildNode(first + half, count - half);
+    m_parents[second] = index;
+    m_nodes[index] = {min, max, second, 0};
+    return index;
+}
+
+void StaticInstanceTree::findVisible(const ViewFrustum& frustum,
+                                     std::vector<GameObject*>& out,
+                                     const OcclusionBuffer* occlusion) {
+    if (m_dirty) {
+        build();
+    } else if (!m_stale.empty()) {
+        refit();
+    }
+    if (m_nodes.empty()) {
+        return;
+    }
+
+    uint32_t stack[64];
+    size_t depth = 0;
+    stack[depth++] = 0;
+
+    while (depth > 0) {
+        auto index = stack[--depth];
+        auto& node = m_nodes[index];
+
+        auto center = (node.min + node.max) * 0.5f;
+        auto extents = (node.max - node.min) * 0.5f;
+
+        bool inside = true;
+        bool outside = false;
+        for (auto& plane : frustum.planes) {
+            float d = glm::dot(plane.normal, center) + plane.distance;
+            float r = glm::dot(glm::abs(plane.normal), extents);
+            if (d < -r) {
+                outside = true;
+                break;
+            }
+            if (d < r) {
+                inside = false;
+            }
+        }
+
+        if (outside) {
+            continue;
+        }
+        if (occlusion && !occlusion->isVisible(node.min, node.max)) {
+            continue;
+        }
+        if (inside && !occlusion) {
+            addNode(index, out);
+            continue;
+        }
+
+        if (node.count > 0) {
+            static_assert(kLeafSize <= 64, "Leaves must fit in one mask");
+            uint64_t visible = ~uint64_t(0);
+            auto first = node.index;
+            if (!inside) {
+                frustum.intersects(&m_spheres.x[first], &m_spheres.y[first],
+                                   &m_spheres.z[first],
+                                   &m_spheres.radius[first], node.count,
+                                   &visible);
+            }
+            for (uint32_t i = 0; i < node.count; ++i) {
+                auto& item = m_items[first + i];
+                if (((visible >> i) & 1) &&
+                    (!occlusion ||
+                     occlusion->isVisible(item.center, item.radius))) {
+                    out.push_back(item.instance);
+                }
+            }
+        } else {
+            stack[depth++] = index + 1;
+            stack[depth++] = node.index;
+        }
+    }
+}
+
+void StaticInstanceTree::addNode(uint32_t node,
+                                 std::vector<GameObject*>& out) const {
+    // Every item under a node is contiguous, so find the node's extent
+    auto last = node;
+    while (m_nodes[last].count == 0) {
+        last = m_nodes[last].index;
+    }
+    auto first = node;
+    while (m_nodes[first].count == 0) {
+        first = first + 1;
+    }
+
+    auto begin = m_nodes[first].index;
+    auto end = m_nodes[last].index + m_nodes[last].count;
+    for (auto i = begin; i < end; ++i) {
+        out.push_back(m_items[i].instance);
+    }
+}
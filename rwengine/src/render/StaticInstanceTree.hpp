@@ -0,0 +1,107 @@
+#ifndef _RWENGINE_STATICINSTANCETREE_HPP_
+#define _RWENGINE_STATICINSTANCETREE_HPP_
+
+#include <glm/glm.hpp>
+#include <render/ViewFrustum.hpp>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class GameObject;
+class InstanceObject;
+class OcclusionBuffer;
+
+/**
+ * @brief Bounding volume hierarchy over the instances that never move
+ *
+ * Whole nodes are tested against the view frustum, nodes entirely inside
+ * it are accepted without testing their instances. Instances added by
+ * GameWorld::placeItems without dynamic object data are kept here, and
+ * skipped when the renderer walks the world's other objects.
+ *
+ * An occlusion buffer can be given as well, then nodes and instances it
+ * hides are skipped too.
+ *
+ * The tree is rebuilt on the first query after it is changed, so that
+ * the LOD links made at the end of each placeItems are accounted for.
+ * Bounds depend on the models loaded, so the instances using a model are
+ * refit, along with the nodes above them, whenever it is streamed in.
+ */
+class StaticInstanceTree {
+public:
+    StaticInstanceTree() : m_dirty(false) {
+    }
+
+    void insert(InstanceObject* instance);
+
+    void remove(InstanceObject* instance);
+
+    /**
+     * @brief Recomputes the bounds of instance, and of the instances using
+     * it as their LOD, on the next query, keeping the structure of the
+     * tree. Call when the model it draws changes.
+     */
+    void updateBounds(InstanceObject* instance);
+
+    /**
+     * @return true if object is culled by this tree
+     */
+    static bool contains(GameObject* object);
+
+    size_t size() const {
+        return m_items.size();
+    }
+
+    /**
+     * @brief Appends the instances that may intersect frustum to out
+     * @param occlusion If not null, instances it hides are left out
+     */
+    void findVisible(const ViewFrustum& frustum, std::vector<GameObject*>& out,
+                     const OcclusionBuffer* occlusion = nullptr);
+
+    /**
+     * @return The radius around the instance's position that covers
+     * everything drawn for it, including its LOD model
+     */
+    static float getCullingRadius(InstanceObject* instance);
+
+private:
+    struct Item {
+        glm::vec3 center;
+        float radius;
+        InstanceObject* instance;
+        /// The leaf holding the item
+        uint32_t leaf;
+    };
+
+    struct Node {
+        glm::vec3 min;
+        glm::vec3 max;
+        /// First item for leaves, the second child otherwise. The first
+        /// child always follows its parent.
+        uint32_t index;
+        /// Number of items, 0 for inner nodes
+        uint32_t count;
+    };
+
+    std::vector<Item> m_items;
+    /// The items' spheres in the same order, for batched culling
+    SphereList m_spheres;
+    std::vector<Node> m_nodes;
+    /// The parent of each node, the root is its own
+    std::vector<uint32_t> m_parents;
+    /// The items whose bounds depend on each instance's model
+    std::unordered_multimap<InstanceObject*, uint32_t> m_dependents;
+    /// Items whose bounds need refitting
+    std::vector<uint32_t> m_stale;
+    bool m_dirty;
+
+    void build();
+    void refit();
+    void fitNode(uint32_t index);
+    uint32_t buildNode(uint32_t first, uint32_t count);
+    void addNode(uint32_t node, std::vector<GameObject*>& out) const;
+};
+
+#endif
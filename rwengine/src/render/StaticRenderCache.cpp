@@ -0,0 +1,179 @@
+#include <render/StaticRenderCache.hpp>
+
+#include <job/WorkContext.hpp>
+#include <objects/InstanceObject.hpp>
+#include <render/ObjectRenderer.hpp>
+#include <render/StaticInstanceTree.hpp>
+#include <render/ViewCamera.hpp>
+
+#include <algorithm>
+#include <atomic>
+
+namespace {
+/// Instances listed per chunk
+constexpr size_t kCacheGrain = 256;
+}
+
+StaticRenderCache::State StaticRenderCache::getState(InstanceObject* instance,
+                                                     const glm::vec3& camera,
+                                                     int hour) const {
+    auto& record = instance->getRenderRecord();
+
+    State state;
+    state.position = instance->getPosition();
+    state.model = record.model;
+    state.lodModel = record.lodModel;
+    state.shown = instance->getModel() && instance->getVisible() &&
+                  record.isShownAt(hour);
+    if (state.shown) {
+        auto offset = state.position - camera;
+        auto selection = record.select(glm::dot(offset, offset));
+        state.draw = selection.draw;
+        state.fading = selection.fading;
+        state.opacity = selection.opacity;
+    }
+    return state;
+}
+
+void StaticRenderCache::update(const std::vector<GameObject*>& instances,
+                               const ViewCamera& camera, int hour,
+                               const ObjectRenderer& renderer,
+                               GLuint errorTexture, WorkContext& work) {
+    ++m_frame;
+
+    glm::vec4 frustum(camera.frustum.near, camera.frustum.far,
+                      camera.frustum.fov, camera.frustum.aspectRatio);
+    bool moved = camera.position != m_cameraPosition ||
+                 camera.rotation != m_cameraRotation ||
+                 frustum != m_cameraFrustum;
+    m_cameraPosition = camera.position;
+    m_cameraRotation = camera.rotation;
+    m_cameraFrustum = frustum;
+
+    // Entries are only added here, the chunks below each update their own
+    m_slots.resize(instances.size());
+    for (size_t i = 0; i < instances.size(); ++i) {
+        m_slots[i] = &m_entries[static_cast<InstanceObject*>(instances[i])];
+    }
+
+    auto chunks = (instances.size() + kCacheGrain - 1) / kCacheGrain;
+    if (m_chunkLists.size() < chunks) {
+        m_chunkLists.resize(chunks);
+    }
+
+    std::atomic<size_t> listed(0);
+    work.parallelFor(
+        instances.size(), kCacheGrain,
+        [&](size_t chunk, size_t begin, size_t end) {
+            ObjectRenderer chunkRenderer = renderer;
+            auto& list = m_chunkLists[chunk];
+            list.clear();
+            size_t chunkListed = 0;
+
+            for (auto i = begin; i < end; ++i) {
+                auto instance = static_cast<InstanceObject*>(instances[i]);
+                auto& entry = *m_slots[i];
+                auto state = getState(instance, camera.position, hour);
+
+                auto firstInstruction = list.instructions.size();
+                auto firstTransform = list.transforms.size();
+
+                bool reuse = entry.reusable && entry.frame + 1 == m_frame &&
+                             entry.state == state &&
+                             camera.frustum.contains(state.position,
+                                                     entry.radius);
+                if (reuse) {
+                    auto transforms = m_list.transforms.begin() +
+                                      entry.firstTransform;
+                    list.transforms.insert(list.transforms.end(), transforms,
+                                           transforms + entry.transformCount);
+
+                    auto base = static_cast<uint32_t>(firstTransform) -
+                                entry.firstTransform;
+                    for (uint32_t n = 0; n < entry.instructionCount; ++n) {
+                        list.instructions.push_back(
+                            m_list.instructions[entry.firstInstruction + n]);
+                        auto& instruction = list.instructions.back();
+                        instruction.transform += base;
+                        if (moved) {
+                            instruction.sortKey = chunkRenderer.getSortKey(
+                                list.getTransform(instruction),
+                                *instruction.dbuff, instruction.drawInfo);
+                        }
+                    }
+                } else {
+                    chunkRenderer.buildRenderList(instance, list);
+                    chunkListed++;
+
+                    entry.radius =
+                        StaticInstanceTree::getCullingRadius(instance);
+                    entry.reusable =
+                        !instance->skeleton &&
+                        camera.frustum.contains(state.position, entry.radius);
+                    for (auto n = firstInstruction;
+                         entry.reusable && n < list.instructions.size(); ++n) {
+                        auto& textures =
+                            list.instructions[n].drawInfo.textures;
+                        if (textures.size() > 0 &&
+                            textures[0] == errorTexture) {
+                            entry.reusable = false;
+                        }
+                    }
+                }
+
+                entry.state = state;
+                entry.frame = m_frame;
+                entry.firstInstruction =
+                    static_cast<uint32_t>(firstInstruction);
+                entry.instructionCount = static_cast<uint32_t>(
+                    list.instructions.size() - firstInstruction);
+                entry.firstTransform = static_cast<uint32_t>(firstTransform);
+                entry.transformCount = static_cast<uint32_t>(
+                    list.transforms.size() - firstTransform);
+            }
+
+            listed += chunkListed;
+        });
+    m_listed = listed;
+
+    // Merge the chunks in order, moving the entries' ranges along with them
+    m_next.clear();
+    for (size_t c = 0; c < chunks; ++c) {
+        auto instructionBase = static_cast<uint32_t>(m_next.size());
+        auto transformBase = static_cast<uint32_t>(m_next.transforms.size());
+        m_next.append(m_chunkLists[c]);
+
+        auto end = std::min(instances.size(), (c + 1) * kCacheGrain);
+        for (auto i = c * kCacheGrain; i < end; ++i) {
+            m_slots[i]->firstInstruction += instructionBase;
+            m_slots[i]->firstTransform += transformBase;
+        }
+    }
+    std::swap(m_list, m_next);
+
+    // The same instructions as before, in the same order, sort the same
+    m_orderReused = !moved && m_listed == 0 && instances == m_instances;
+    if (!m_orderReused) {
+        m_order = m_sorter.sort(m_list);
+    }
+    m_instances = instances;
+
+    // Forget instances that have been out of view for a while
+    if (m_entries.size() > 2 * instances.size() + 1024) {
+        for (auto it = m_entries.begin(); it != m_entries.end();) {
+            if (it->second.frame != m_frame) {
+                it = m_entries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+}
+
+void StaticRenderCache::clear() {
+    // Swapped out so the buckets are freed, clearing again is then free
+    decltype(m_entries)().swap(m_entries);
+    m_instances.clear();
+    m_list.clear();
+    m_order.clear();
+}
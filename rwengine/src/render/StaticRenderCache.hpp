@@ -0,0 +1,132 @@
+#ifndef _RWENGINE_STATICRENDERCACHE_HPP_
+#define _RWENGINE_STATICRENDERCACHE_HPP_
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <render/OpenGLRenderer.hpp>
+#include <render/RenderSort.hpp>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class GameObject;
+class InstanceObject;
+class Model;
+class ObjectRenderer;
+class ViewCamera;
+class WorkContext;
+
+/**
+ * @brief Keeps the render list of static instances, and its order, between
+ * frames
+ *
+ * An instance's instructions are copied from the previous frame if it was
+ * listed then, was entirely inside the view both times, and is drawn with
+ * the same models, level of detail, fade and time of day. Other instances
+ * are listed again. Copied instructions are given new sort keys if the
+ * camera moved. If it held still and nothing was listed again, the
+ * previous order is reused without sorting.
+ *
+ * Instances drawn with the missing texture, or with a skeleton, are listed
+ * every frame since their instructions can change by themselves.
+ */
+class StaticRenderCache {
+public:
+    /**
+     * @brief Lists instances, all static, as seen by renderer
+     * @param camera The camera renderer was made with
+     */
+    void update(const std::vector<GameObject*>& instances,
+                const ViewCamera& camera, int hour,
+                const ObjectRenderer& renderer, GLuint errorTexture,
+                WorkContext& work);
+
+    /**
+     * @brief Forgets every instance, so the next update lists them all
+     */
+    void clear();
+
+    const RenderList& getList() const {
+        return m_list;
+    }
+
+    /**
+     * @return The list's instructions in sorted order
+     */
+    const RenderOrder& getOrder() const {
+        return m_order;
+    }
+
+    /**
+     * @return The number of instances listed again by the last update
+     */
+    size_t getListedCount() const {
+        return m_listed;
+    }
+
+    /**
+     * @return Whether the last update reused the previous order
+     */
+    bool isOrderReused() const {
+        return m_orderReused;
+    }
+
+private:
+    /// Everything that decides what an instance lists
+    struct State {
+        glm::vec3 position;
+        Model* model = nullptr;
+        Model* lodModel = nullptr;
+        bool shown = false;
+        int draw = -1;
+        int fading = -1;
+        float opacity = 0.f;
+
+        bool operator==(const State& other) const {
+            return position == other.position && model == other.model &&
+                   lodModel == other.lodModel && shown == other.shown &&
+                   draw == other.draw && fading == other.fading &&
+                   opacity == other.opacity;
+        }
+    };
+
+    struct Entry {
+        State state;
+        /// Covers everything the instance draws
+        float radius = 0.f;
+        bool reusable = false;
+        /// The update the instance was last listed in
+        uint64_t frame = 0;
+        /// Where the instructions and transforms are in the list
+        uint32_t firstInstruction = 0;
+        uint32_t instructionCount = 0;
+        uint32_t firstTransform = 0;
+        uint32_t transformCount = 0;
+    };
+
+    std::unordered_map<InstanceObject*, Entry> m_entries;
+    /// Each instance's entry, in the order they are listed
+    std::vector<Entry*> m_slots;
+    std::vector<GameObject*> m_instances;
+
+    RenderList m_list;
+    RenderList m_next;
+    std::vector<RenderList> m_chunkLists;
+    RenderSorter m_sorter;
+    RenderOrder m_order;
+
+    uint64_t m_frame = 0;
+    size_t m_listed = 0;
+    bool m_orderReused = false;
+
+    /// The camera of the last update
+    glm::vec3 m_cameraPosition = glm::vec3(0.f);
+    glm::quat m_cameraRotation;
+    glm::vec4 m_cameraFrustum = glm::vec4(0.f);
+
+    State getState(InstanceObject* instance, const glm::vec3& camera,
+                   int hour) const;
+};
+
+#endif
@@ -0,0 +1,127 @@
+#include <render/UniformRing.hpp>
+
+#include <rw/defines.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+constexpr size_t UniformRing::kRegions;
+
+namespace {
+/// How long to wait on a fence before checking it again, in nanoseconds
+constexpr GLuint64 kFenceTimeout = 1000000000;
+
+GLintptr alignUp(GLintptr value, GLintptr alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+}
+
+UniformRing::UniformRing(GLsizeiptr regionSize, GLsizeiptr bindingSize)
+    : buffer(0)
+    , regionSize(0)
+    , bindingSize(bindingSize)
+    , alignment(1)
+    , mapping(nullptr)
+    , region(0)
+    , offset(0)
+    , fences{} {
+    GLint uboAlignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uboAlignment);
+    alignment = std::max<GLint>(1, uboAlignment);
+
+    // Keep every region start aligned, and room for a whole binding
+    this->regionSize = alignUp(std::max(regionSize, bindingSize), alignment);
+
+    // Bindings near the end of the last region run past it
+    auto size = this->regionSize * kRegions + bindingSize;
+
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+
+    if (ogl_ext_ARB_buffer_storage) {
+        const GLbitfield flags =
+            GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_UNIFORM_BUFFER, size, nullptr, flags);
+        mapping = static_cast<char*>(
+            glMapBufferRange(GL_UNIFORM_BUFFER, 0, size, flags));
+
+        if (mapping == nullptr) {
+            // Immutable storage can't be reallocated, start again
+            glDeleteBuffers(1, &buffer);
+            glGenBuffers(1, &buffer);
+            glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        }
+    }
+
+    if (mapping == nullptr) {
+        glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    }
+}
+
+UniformRing::~UniformRing() {
+    for (auto& fence : fences) {
+        if (fence) {
+            glDeleteSync(fence);
+        }
+    }
+    if (mapping) {
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glUnmapBuffer(GL_UNIFORM_BUFFER);
+    }
+    glDeleteBuffers(1, &buffer);
+}
+
+GLintptr UniformRing::upload(GLuint binding, const void* data,
+                             GLsizeiptr size) {
+    RW_CHECK(size <= bindingSize, "Upload is larger than the binding");
+
+    if (offset + size > regionSize) {
+        nextRegion();
+    }
+
+    auto start = static_cast<GLintptr>(region) * regionSize + offset;
+
+    if (mapping) {
+        std::memcpy(mapping + start, data, size);
+    } else {
+        // The fences guarantee the GPU is done with this range
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        auto dest = glMapBufferRange(GL_UNIFORM_BUFFER, start, size,
+                                     GL_MAP_WRITE_BIT |
+                                         GL_MAP_INVALIDATE_RANGE_BIT |
+                                         GL_MAP_UNSYNCHRONIZED_BIT);
+        if (dest) {
+            std::memcpy(dest, data, size);
+            glUnmapBuffer(GL_UNIFORM_BUFFER);
+        }
+    }
+
+    glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, start, bindingSize);
+
+    offset = alignUp(offset + size, alignment);
+    return start;
+}
+
+void UniformRing::nextFrame() {
+    if (offset > 0) {
+        nextRegion();
+    }
+}
+
+void UniformRing::nextRegion() {
+    fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    region = (region + 1) % kRegions;
+    offset = 0;
+
+    auto& fence = fences[region];
+    if (fence) {
+        GLenum result;
+        do {
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                      kFenceTimeout);
+        } while (result == GL_TIMEOUT_EXPIRED);
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+}
@@ -0,0 +1,83 @@
+#ifndef _RWENGINE_UNIFORMRING_HPP_
+#define _RWENGINE_UNIFORMRING_HPP_
+
+#include <gl/gl_core_3_3.h>
+
+#include <cstddef>
+
+/**
+ * @brief Streams uniform blocks through one buffer split into regions
+ *
+ * Uploads are written one after another into the current region and bound
+ * with glBindBufferRange, so nothing is reallocated between draws. Once a
+ * region is full, or a new frame starts, a fence is placed behind it and
+ * writing moves on to the next region, waiting for that region's fence
+ * first so the GPU is never reading what is being overwritten.
+ *
+ * With ARB_buffer_storage the buffer is mapped once, persistently. Without
+ * it, each upload maps its own range unsynchronized, the fences make that
+ * safe.
+ */
+class UniformRing {
+public:
+    /// Number of regions, so two frames can be in flight while writing
+    static constexpr size_t kRegions = 3;
+
+    /**
+     * @param regionSize Bytes available for uploads in each region
+     * @param bindingSize Bytes bound for each upload, the size of the
+     * uniform block. Uploads may be smaller than this.
+     */
+    UniformRing(GLsizeiptr regionSize, GLsizeiptr bindingSize);
+    ~UniformRing();
+
+    UniformRing(const UniformRing&) = delete;
+    UniformRing& operator=(const UniformRing&) = delete;
+
+    /**
+     * @brief Copies data into the ring and binds it to the binding point
+     * @return The offset of the data in the buffer
+     *
+     * Leaves the buffer bound to GL_UNIFORM_BUFFER.
+     */
+    GLintptr upload(GLuint binding, const void* data, GLsizeiptr size);
+
+    /**
+     * @brief Moves on to the next region if anything was written this frame
+     */
+    void nextFrame();
+
+    GLuint getName() const {
+        return buffer;
+    }
+
+    bool isPersistent() const {
+        return mapping != nullptr;
+    }
+
+    GLsizeiptr getRegionSize() const {
+        return regionSize;
+    }
+
+    GLintptr getAlignment() const {
+        return alignment;
+    }
+
+private:
+    GLuint buffer;
+    GLsizeiptr regionSize;
+    GLsizeiptr bindingSize;
+    GLintptr alignment;
+
+    /// Persistent mapping of the whole buffer, if supported
+    char* mapping;
+
+    size_t region;
+    /// Next free byte, relative to the start of the current region
+    GLintptr offset;
+    GLsync fences[kRegions];
+
+    void nextRegion();
+};
+
+#endif
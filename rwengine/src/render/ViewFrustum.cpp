@@ -0,0 +1,93 @@
+#include <render/ViewFrustum.hpp>
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#define RW_FRUSTUM_SSE 1
+#endif
+#if defined(__AVX__)
+#define RW_FRUSTUM_AVX 1
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define RW_FRUSTUM_NEON 1
+#endif
+
+void ViewFrustum::intersects(const float* x, const float* y, const float* z,
+                             const float* radius, size_t count,
+                             uint64_t* visible) const {
+    std::fill(visible, visible + getMaskSize(count), 0);
+
+    // The planes are evaluated in the same order and with the same
+    // comparison as the scalar test, so the results match it exactly. Each
+    // loop handles a multiple of the next one's width, so a group of results
+    // never straddles two mask words.
+    size_t i = 0;
+
+#if RW_FRUSTUM_AVX
+    for (; i + 8 <= count; i += 8) {
+        __m256 px = _mm256_loadu_ps(x + i);
+        __m256 py = _mm256_loadu_ps(y + i);
+        __m256 pz = _mm256_loadu_ps(z + i);
+        __m256 nr = _mm256_sub_ps(_mm256_setzero_ps(),
+                                  _mm256_loadu_ps(radius + i));
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (auto& plane : planes) {
+            __m256 d = _mm256_add_ps(
+                _mm256_mul_ps(px, _mm256_set1_ps(plane.normal.x)),
+                _mm256_mul_ps(py, _mm256_set1_ps(plane.normal.y)));
+            d = _mm256_add_ps(
+                d, _mm256_mul_ps(pz, _mm256_set1_ps(plane.normal.z)));
+            d = _mm256_add_ps(d, _mm256_set1_ps(plane.distance));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, nr, _CMP_NLT_UQ));
+        }
+        auto mask = static_cast<uint64_t>(_mm256_movemask_ps(inside));
+        visible[i / 64] |= mask << (i % 64);
+    }
+#endif
+
+#if RW_FRUSTUM_SSE
+    for (; i + 4 <= count; i += 4) {
+        __m128 px = _mm_loadu_ps(x + i);
+        __m128 py = _mm_loadu_ps(y + i);
+        __m128 pz = _mm_loadu_ps(z + i);
+        __m128 nr = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius + i));
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (auto& plane : planes) {
+            __m128 d = _mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(plane.normal.x)),
+                                  _mm_mul_ps(py, _mm_set1_ps(plane.normal.y)));
+            d = _mm_add_ps(d, _mm_mul_ps(pz, _mm_set1_ps(plane.normal.z)));
+            d = _mm_add_ps(d, _mm_set1_ps(plane.distance));
+            inside = _mm_and_ps(inside, _mm_cmpnlt_ps(d, nr));
+        }
+        auto mask = static_cast<uint64_t>(_mm_movemask_ps(inside));
+        visible[i / 64] |= mask << (i % 64);
+    }
+#elif RW_FRUSTUM_NEON
+    const uint32_t laneBits[4] = {1, 2, 4, 8};
+    const uint32x4_t bits = vld1q_u32(laneBits);
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t px = vld1q_f32(x + i);
+        float32x4_t py = vld1q_f32(y + i);
+        float32x4_t pz = vld1q_f32(z + i);
+        float32x4_t nr = vnegq_f32(vld1q_f32(radius + i));
+        uint32x4_t inside = vdupq_n_u32(~0u);
+        for (auto& plane : planes) {
+            float32x4_t d = vaddq_f32(vmulq_n_f32(px, plane.normal.x),
+                                      vmulq_n_f32(py, plane.normal.y));
+            d = vaddq_f32(d, vmulq_n_f32(pz, plane.normal.z));
+            d = vaddq_f32(d, vdupq_n_f32(plane.distance));
+            inside = vbicq_u32(inside, vcltq_f32(d, nr));
+        }
+        auto mask = static_cast<uint64_t>(vaddvq_u32(vandq_u32(inside, bits)));
+        visible[i / 64] |= mask << (i % 64);
+    }
+#endif
+
+    for (; i < count; ++i) {
+        if (intersects(glm::vec3(x[i], y[i], z[i]), radius[i])) {
+            visible[i / 64] |= uint64_t(1) << (i % 64);
+        }
+    }
+}
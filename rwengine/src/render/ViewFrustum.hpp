@@ -1,11 +1,42 @@
 #ifndef _VIEWFRUSTUM_HPP_
 #define _VIEWFRUSTUM_HPP_
+#include <cstddef>
+#include <cstdint>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <vector>
 #ifdef RW_WINDOWS
 #include <rw_mingw.hpp>
 #endif
 
+/**
+ * @brief Spheres stored as separate coordinate arrays, for batched culling
+ */
+struct SphereList {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+    std::vector<float> radius;
+
+    void add(const glm::vec3& center, float r) {
+        x.push_back(center.x);
+        y.push_back(center.y);
+        z.push_back(center.z);
+        radius.push_back(r);
+    }
+
+    size_t size() const {
+        return x.size();
+    }
+
+    void clear() {
+        x.clear();
+        y.clear();
+        z.clear();
+        radius.clear();
+    }
+};
+
 class ViewFrustum {
 public:
     class ViewPlane {
@@ -55,6 +86,46 @@ public:
 
         return result;
     }
+
+    /**
+     * @return true if the sphere is entirely inside the frustum
+     */
+    bool contains(glm::vec3 center, float radius) const {
+        for (size_t i = 0; i < 6; ++i) {
+            if (glm::dot(planes[i].normal, center) + planes[i].distance <
+                radius) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Tests many spheres at once, matching intersects() for each
+     * @param visible Receives a bit per sphere, set when the sphere may be
+     * visible. Must have room for getMaskSize(count) words.
+     *
+     * Uses SSE or AVX on x86 and NEON on AArch64, where available.
+     */
+    void intersects(const float* x, const float* y, const float* z,
+                    const float* radius, size_t count,
+                    uint64_t* visible) const;
+
+    void intersects(const SphereList& spheres, uint64_t* visible) const {
+        intersects(spheres.x.data(), spheres.y.data(), spheres.z.data(),
+                   spheres.radius.data(), spheres.size(), visible);
+    }
+
+    /**
+     * @return The number of mask words needed for count spheres
+     */
+    static size_t getMaskSize(size_t count) {
+        return (count + 63) / 64;
+    }
+
+    static bool isVisible(const uint64_t* visible, size_t i) {
+        return (visible[i / 64] >> (i % 64)) & 1;
+    }
 };
 
 #endif
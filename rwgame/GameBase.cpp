@@ -31,7 +31,12 @@ GameBase::GameBase(Logger &inlog, int argc, char *argv[]) : log(inlog) {
                                                   "Directly start a new game")(
         "test,t", "Starts a new game in a test location")(
         "load,l", po::value<std::string>(), "Load save file")(
-        "benchmark,b", po::value<std::string>(), "Run benchmark from file");
+        "benchmark,b", po::value<std::string>(), "Run benchmark from file")(
+        "headless", "Simulate a new game without a window, rendering or audio")(
+        "speed", po::value<float>(),
+        "Headless speed as a multiple of realtime, unlimited if 0")(
+        "duration", po::value<float>(),
+        "Seconds of game time to simulate headless before exiting");
 
     po::variables_map &vm = options;
     try {
@@ -55,6 +60,11 @@ GameBase::GameBase(Logger &inlog, int argc, char *argv[]) : log(inlog) {
     if (vm.count("fullscreen")) {
         fullscreen = true;
     }
+    if (vm.count("headless")) {
+        // There's no window or GL context to initialise
+        headless = true;
+        return;
+    }
 
     if (SDL_Init(SDL_INIT_VIDEO) < 0)
         throw std::runtime_error("Failed to initialize SDL2!");
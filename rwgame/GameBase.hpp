@@ -23,10 +23,18 @@ public:
         return config;
     }
 
+    /**
+     * @return true if there's no window, rendering or audio
+     */
+    bool isHeadless() const {
+        return headless;
+    }
+
 protected:
     Logger& log;
     GameConfig config{"openrw.ini"};
     GameWindow window;
+    bool headless = false;
     boost::program_options::variables_map options;
 };
 
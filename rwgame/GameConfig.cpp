@@ -74,6 +74,12 @@ int GameConfig::handler(void* user, const char* section, const char* name,
         self->m_gameLanguage = value;
     } else if (MATCH("input", "invert_y")) {
         self->m_inputInvertY = atoi(value) > 0;
+    } else if (MATCH("game", "collision_cache")) {
+        self->m_collisionCachePath = value;
+    } else if (MATCH("game", "pack_textures")) {
+        self->m_packTextures = atoi(value) > 0;
+    } else if (MATCH("game", "streaming_budget")) {
+        self->m_streamingBudget = atoi(value);
     } else {
         RW_MESSAGE("Unhandled config entry [" << section << "] " << name
                                               << " = " << value);
@@ -32,6 +32,15 @@ public:
     bool getInputInvertY() const {
         return m_inputInvertY;
     }
+    const std::string& getCollisionCachePath() const {
+        return m_collisionCachePath;
+    }
+    bool getPackTextures() const {
+        return m_packTextures;
+    }
+    int getStreamingBudget() const {
+        return m_streamingBudget;
+    }
 
 private:
     static std::string getDefaultConfigPath();
@@ -52,6 +61,16 @@ private:
 
     /// Invert the y axis for camera control.
     bool m_inputInvertY;
+
+    /// Where to cache collision BVHs, disabled if empty
+    std::string m_collisionCachePath;
+
+    /// Pack world textures into texture arrays
+    bool m_packTextures = false;
+
+    /// Megabytes of instance models and textures to keep loaded, or 0 to
+    /// load them all up front
+    int m_streamingBudget = 0;
 };
 
 #endif
@@ -2,6 +2,7 @@
 #include "DrawUI.hpp"
 #include "State.hpp"
 #include "states/BenchmarkState.hpp"
+#include "states/HeadlessState.hpp"
 #include "states/IngameState.hpp"
 #include "states/LoadingState.hpp"
 #include "states/MenuState.hpp"
@@ -20,6 +21,7 @@
 
 #include <boost/algorithm/string/predicate.hpp>
 #include <functional>
+#include <thread>
 
 std::map<GameRenderer::SpecialModel, std::string> kSpecialModels = {
     {GameRenderer::ZoneCylinderA, "zonecyla.dff"},
@@ -29,9 +31,12 @@ std::map<GameRenderer::SpecialModel, std::string> kSpecialModels = {
 #define MOUSE_SENSITIVITY_SCALE 2.5f
 
 RWGame::RWGame(Logger& log, int argc, char* argv[])
-    : GameBase(log, argc, argv)
-    , data(&log, &work, config.getGameDataPath())
-    , renderer(&log, &data) {
+    : GameBase(log, argc, argv), data(&log, &work, config.getGameDataPath()) {
+    if (!headless) {
+        renderer = std::make_unique<GameRenderer>(&log, &data);
+        debug = std::make_unique<DebugDraw>();
+    }
+
     bool newgame = options.count("newgame");
     bool test = options.count("test");
     std::string startSave(
@@ -39,6 +44,8 @@ RWGame::RWGame(Logger& log, int argc, char* argv[])
     std::string benchFile(options.count("benchmark")
                               ? options["benchmark"].as<std::string>()
                               : "");
+    float duration =
+        options.count("duration") ? options["duration"].as<float>() : 0.f;
 
     log.info("Game", "Game directory: " + config.getGameDataPath());
 
@@ -47,38 +54,59 @@ RWGame::RWGame(Logger& log, int argc, char* argv[])
                                  config.getGameDataPath());
     }
 
+    data.headless = headless;
     data.load();
 
-    for (const auto& p : kSpecialModels) {
-        auto model = data.loadClump(p.second);
-        renderer.setSpecialModel(p.first, model);
+    if (!config.getCollisionCachePath().empty()) {
+        data.collisionShapes.setBvhCacheDirectory(
+            config.getCollisionCachePath());
+    }
+
+    if (config.getPackTextures()) {
+        data.textureArrays = std::make_unique<TextureArrays>();
     }
 
-    // Set up text renderer
-    renderer.text.setFontTexture(0, "pager");
-    renderer.text.setFontTexture(1, "font1");
-    renderer.text.setFontTexture(2, "font2");
+    if (config.getStreamingBudget() > 0) {
+        data.streaming = std::make_unique<StreamingManager>(
+            &data, &work, size_t(config.getStreamingBudget()) * 1024 * 1024);
+    }
+
+    if (!headless) {
+        for (const auto& p : kSpecialModels) {
+            auto model = data.loadClump(p.second);
+            renderer->setSpecialModel(p.first, model);
+        }
 
-    debug.setDebugMode(btIDebugDraw::DBG_DrawWireframe |
-                       btIDebugDraw::DBG_DrawConstraints |
-                       btIDebugDraw::DBG_DrawConstraintLimits);
-    debug.setShaderProgram(renderer.worldProg);
+        // Set up text renderer
+        renderer->text.setFontTexture(0, "pager");
+        renderer->text.setFontTexture(1, "font1");
+        renderer->text.setFontTexture(2, "font2");
+
+        debug->setDebugMode(btIDebugDraw::DBG_DrawWireframe |
+                            btIDebugDraw::DBG_DrawConstraints |
+                            btIDebugDraw::DBG_DrawConstraintLimits);
+        debug->setShaderProgram(renderer->worldProg);
+    }
 
     data.loadDynamicObjects(config.getGameDataPath() + "/data/object.dat");
 
     data.loadGXT("text/" + config.getGameLanguage() + ".gxt");
 
-    getRenderer().water.setWaterTable(data.waterHeights, 48, data.realWater,
-                                      128 * 128);
+    if (!headless) {
+        getRenderer().water.setWaterTable(data.waterHeights, 48,
+                                          data.realWater, 128 * 128);
 
-    for (int m = 0; m < MAP_BLOCK_SIZE; ++m) {
-        std::string num = (m < 10 ? "0" : "");
-        std::string name = "radar" + num + std::to_string(m);
-        data.loadTXD(name + ".txd");
+        for (int m = 0; m < MAP_BLOCK_SIZE; ++m) {
+            std::string num = (m < 10 ? "0" : "");
+            std::string name = "radar" + num + std::to_string(m);
+            data.loadTXD(name + ".txd");
+        }
     }
 
     StateManager::get().enter<LoadingState>(this, [=]() {
-        if (!benchFile.empty()) {
+        if (headless) {
+            StateManager::get().enter<HeadlessState>(this, duration);
+        } else if (!benchFile.empty()) {
             StateManager::get().enter<BenchmarkState>(this, benchFile);
         } else if (test) {
             StateManager::get().enter<IngameState>(this, true, "test");
@@ -107,7 +135,7 @@ void RWGame::newGame() {
 
     // Destroy the current world and start over
     world = std::make_unique<GameWorld>(&log, &work, &data);
-    world->dynamicsWorld->setDebugDrawer(&debug);
+    world->dynamicsWorld->setDebugDrawer(debug.get());
 
     // Associate the new world with the new state and vice versa
     state.world = world.get();
@@ -117,6 +145,9 @@ void RWGame::newGame() {
         world->data->loadZone(ipl.second);
         world->placeItems(ipl.second);
     }
+
+    // Store any collision BVHs built for the placed items
+    data.collisionShapes.saveBvhCache();
 }
 
 void RWGame::saveGame(const std::string& savename) {
@@ -355,6 +386,10 @@ void RWGame::handleCheatInput(char symbol) {
 }
 
 int RWGame::run() {
+    if (headless) {
+        return runHeadless();
+    }
+
     last_clock_time = clock.now();
 
     // Loop until we run out of states.
@@ -441,7 +476,7 @@ int RWGame::run() {
 
         RW_PROFILE_BEGIN("state");
         if (StateManager::get().states.size() > 0) {
-            StateManager::get().draw(&renderer);
+            StateManager::get().draw(renderer.get());
         }
         RW_PROFILE_END();
         RW_PROFILE_END();
@@ -459,9 +494,36 @@ int RWGame::run() {
     return 0;
 }
 
+int RWGame::runHeadless() {
+    float speed = options.count("speed") ? options["speed"].as<float>() : 0.f;
+    auto start = clock.now();
+    uint64_t ticks = 0;
+
+    while (!StateManager::get().states.empty()) {
+        if (speed > 0.f) {
+            // Wait for realtime to catch up with the game
+            std::chrono::duration<double> wait(ticks * GAME_TIMESTEP / speed);
+            std::this_thread::sleep_until(
+                start +
+                std::chrono::duration_cast<decltype(clock)::duration>(wait));
+        }
+
+        StateManager::get().tick(GAME_TIMESTEP);
+        tick(GAME_TIMESTEP);
+        ticks++;
+
+        StateManager::get().updateStack();
+    }
+
+    StateManager::get().clear();
+
+    return 0;
+}
+
 void RWGame::tick(float dt) {
-    // Process the Engine's background work.
-    work.update();
+    // Process the Engine's background work, leaving anything over budget
+    // for the next tick.
+    lastWorkPending = work.update(GAME_WORK_BUDGET);
 
     State* currState = StateManager::get().states.back().get();
 
@@ -534,6 +596,10 @@ void RWGame::tick(float dt) {
     // render() needs two cameras to smoothly interpolate between ticks.
     lastCam = nextCam;
     nextCam = currState->getCamera();
+
+    if (data.streaming) {
+        data.streaming->update(nextCam.position);
+    }
 }
 
 void RWGame::render(float alpha, float time) {
@@ -542,7 +608,7 @@ void RWGame::render(float alpha, float time) {
     getRenderer().getRenderer()->swap();
 
     glm::ivec2 windowSize = getWindow().getSize();
-    renderer.setViewport(windowSize.x, windowSize.y);
+    renderer->setViewport(windowSize.x, windowSize.y);
 
     ViewCamera viewCam;
     viewCam.frustum.fov = glm::radians(90.f);
@@ -603,13 +669,13 @@ void RWGame::render(float alpha, float time) {
     glEnable(GL_DEPTH_TEST);
     glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
 
-    renderer.getRenderer()->pushDebugGroup("World");
+    renderer->getRenderer()->pushDebugGroup("World");
 
     RW_PROFILE_BEGIN("world");
-    renderer.renderWorld(world.get(), viewCam, alpha);
+    renderer->renderWorld(world.get(), viewCam, alpha);
     RW_PROFILE_END();
 
-    renderer.getRenderer()->popDebugGroup();
+    renderer->getRenderer()->popDebugGroup();
 
     RW_PROFILE_BEGIN("debug");
     switch (debugview_) {
@@ -618,7 +684,7 @@ void RWGame::render(float alpha, float time) {
             break;
         case DebugViewMode::Physics:
             world->dynamicsWorld->debugDrawWorld();
-            debug.flush(&renderer);
+            debug->flush(renderer.get());
             break;
         case DebugViewMode::Navigation:
             renderDebugPaths(time);
@@ -631,7 +697,7 @@ void RWGame::render(float alpha, float time) {
     }
     RW_PROFILE_END();
 
-    drawOnScreenText(world.get(), &renderer);
+    drawOnScreenText(world.get(), renderer.get());
 }
 
 void RWGame::renderDebugStats(float time) {
@@ -656,8 +722,19 @@ void RWGame::renderDebugStats(float time) {
     ss << "FPS: " << (1000.f / time_average) << " (" << time_average << "ms)\n"
        << "Frame: " << time_ms << "ms\n"
        << "Draws/Textures/Buffers: " << lastDraws << "/"
-       << renderer.getRenderer()->getTextureCount() << "/"
-       << renderer.getRenderer()->getBufferCount() << "\n";
+       << renderer->getRenderer()->getTextureCount() << "/"
+       << renderer->getRenderer()->getBufferCount() << "\n"
+       << "Avoided Textures/Buffers: "
+       << renderer->getRenderer()->getAvoidedTextureCount() << "/"
+       << renderer->getRenderer()->getAvoidedBufferCount() << "\n"
+       << "Work Pending: " << lastWorkPending << "/"
+       << work.getPendingCount() << "\n";
+    if (data.streaming) {
+        ss << "Streamed: " << data.streaming->getLoadedBytes() / 1024 / 1024
+           << "/" << data.streaming->getBudget() / 1024 / 1024 << " MB, "
+           << data.streaming->getLoadingCount() << " loading, "
+           << data.streaming->getEvictedCount() << " evicted\n";
+    }
 
     TextRenderer::TextInfo ti;
     ti.text = GameStringUtil::fromString(ss.str());
@@ -665,7 +742,7 @@ void RWGame::renderDebugStats(float time) {
     ti.screenPosition = glm::vec2(10.f, 10.f);
     ti.size = 15.f;
     ti.baseColour = glm::u8vec3(255);
-    renderer.text.renderText(ti);
+    renderer->text.renderText(ti);
 
     /*while( engine->log.size() > 0 && engine->log.front().time + 10.f <
     engine->gameTime ) {
@@ -707,16 +784,16 @@ void RWGame::renderDebugPaths(float time) {
     for (AIGraphNode* n : world->aigraph.nodes) {
         btVector3 p(n->position.x, n->position.y, n->position.z);
         auto& col = n->type == AIGraphNode::Pedestrian ? pedColour : roadColour;
-        debug.drawLine(p - btVector3(0.f, 0.f, 1.f),
-                       p + btVector3(0.f, 0.f, 1.f), col);
-        debug.drawLine(p - btVector3(1.f, 0.f, 0.f),
-                       p + btVector3(1.f, 0.f, 0.f), col);
-        debug.drawLine(p - btVector3(0.f, 1.f, 0.f),
-                       p + btVector3(0.f, 1.f, 0.f), col);
+        debug->drawLine(p - btVector3(0.f, 0.f, 1.f),
+                        p + btVector3(0.f, 0.f, 1.f), col);
+        debug->drawLine(p - btVector3(1.f, 0.f, 0.f),
+                        p + btVector3(1.f, 0.f, 0.f), col);
+        debug->drawLine(p - btVector3(0.f, 1.f, 0.f),
+                        p + btVector3(0.f, 1.f, 0.f), col);
 
         for (AIGraphNode* c : n->connections) {
             btVector3 f(c->position.x, c->position.y, c->position.z);
-            debug.drawLine(p, f, col);
+            debug->drawLine(p, f, col);
         }
     }
 
@@ -727,13 +804,13 @@ void RWGame::renderDebugPaths(float time) {
         btVector3 maxColor(0.f, 1.f, 0.f);
         btVector3 min(garage.min.x, garage.min.y, garage.min.z);
         btVector3 max(garage.max.x, garage.max.y, garage.max.z);
-        debug.drawLine(min, min + btVector3(0.5f, 0.f, 0.f), minColor);
-        debug.drawLine(min, min + btVector3(0.f, 0.5f, 0.f), minColor);
-        debug.drawLine(min, min + btVector3(0.f, 0.f, 0.5f), minColor);
+        debug->drawLine(min, min + btVector3(0.5f, 0.f, 0.f), minColor);
+        debug->drawLine(min, min + btVector3(0.f, 0.5f, 0.f), minColor);
+        debug->drawLine(min, min + btVector3(0.f, 0.f, 0.5f), minColor);
 
-        debug.drawLine(max, max - btVector3(0.5f, 0.f, 0.f), maxColor);
-        debug.drawLine(max, max - btVector3(0.f, 0.5f, 0.f), maxColor);
-        debug.drawLine(max, max - btVector3(0.f, 0.f, 0.5f), maxColor);
+        debug->drawLine(max, max - btVector3(0.5f, 0.f, 0.f), maxColor);
+        debug->drawLine(max, max - btVector3(0.f, 0.5f, 0.f), maxColor);
+        debug->drawLine(max, max - btVector3(0.f, 0.f, 0.5f), maxColor);
     }
 
     // Draw vehicle generators
@@ -749,12 +826,12 @@ void RWGame::renderDebugPaths(float time) {
                          .rotate(btVector3(0.f, 0.f, 1.f), heading);
         auto left = btVector3(-0.15f, -0.15f, 0.f)
                         .rotate(btVector3(0.f, 0.f, 1.f), heading);
-        debug.drawLine(position, position + back, color);
-        debug.drawLine(position, position + right, color);
-        debug.drawLine(position, position + left, color);
+        debug->drawLine(position, position + back, color);
+        debug->drawLine(position, position + right, color);
+        debug->drawLine(position, position + left, color);
     }
 
-    debug.flush(&renderer);
+    debug->flush(renderer.get());
 }
 
 void RWGame::renderDebugObjects(float time, ViewCamera& camera) {
@@ -773,7 +850,7 @@ void RWGame::renderDebugObjects(float time, ViewCamera& camera) {
     ti.screenPosition = glm::vec2(10.f, 10.f);
     ti.size = 15.f;
     ti.baseColour = glm::u8vec3(255);
-    renderer.text.renderText(ti);
+    renderer->text.renderText(ti);
 
     // Render worldspace overlay for nearby objects
     constexpr float kNearbyDistance = 25.f;
@@ -795,7 +872,7 @@ void RWGame::renderDebugObjects(float time, ViewCamera& camera) {
         screen.y = viewport.w - screen.y;
         ti.screenPosition = glm::vec2(screen);
         ti.size = 10.f;
-        renderer.text.renderText(ti);
+        renderer->text.renderText(ti);
     };
 
     for (auto& p : world->vehiclePool.objects) {
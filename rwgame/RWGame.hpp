@@ -18,8 +18,9 @@ class PlayerController;
 class RWGame : public GameBase {
     WorkContext work;
     GameData data;
-    GameRenderer renderer;
-    DebugDraw debug;
+    /// Both are null when headless
+    std::unique_ptr<GameRenderer> renderer;
+    std::unique_ptr<DebugDraw> debug;
     GameState state;
 
     std::unique_ptr<GameWorld> world;
@@ -44,6 +45,7 @@ class RWGame : public GameBase {
 
     DebugViewMode debugview_ = DebugViewMode::Disabled;
     int lastDraws;  /// Number of draws issued for the last frame.
+    size_t lastWorkPending = 0;  /// Finished jobs left after the last tick.
 
     std::string cheatInputWindow = std::string(32, ' ');
 
@@ -74,7 +76,7 @@ public:
     }
 
     GameRenderer& getRenderer() {
-        return renderer;
+        return *renderer;
     }
 
     ScriptMachine *getScriptVM() const {
@@ -127,6 +129,12 @@ public:
     PlayerController* getPlayer();
 
 private:
+    /**
+     * Ticks the states and engine without rendering, as fast as possible
+     * or at the --speed multiple of realtime
+     */
+    int runHeadless();
+
     void tick(float dt);
     void render(float alpha, float dt);
 
@@ -16,4 +16,7 @@ bool hitWorldRay(const glm::vec3& start, const glm::vec3& direction,
 
 #define GAME_TIMESTEP (1.f / 30.f)
 
+/// Time spent completing background work each tick, e.g. texture uploads
+#define GAME_WORK_BUDGET std::chrono::milliseconds(4)
+
 #endif  // GAME_HPP
@@ -54,7 +54,17 @@ std::shared_ptr<Menu> DebugState::createDebugMenu() {
          {"Full Health", [=] { player->getCurrentState().health = 100.f; }},
          {"Full Armour", [=] { player->getCurrentState().armour = 100.f; }},
          {"Cull Here",
-          [=] { game->getRenderer().setCullOverride(true, _debugCam); }}},
+          [=] { game->getRenderer().setCullOverride(true, _debugCam); }},
+         {"Toggle Occlusion Culling",
+          [=] {
+              auto& renderer = game->getRenderer();
+              renderer.occlusionCulling = !renderer.occlusionCulling;
+          }},
+         {"Toggle Static Draw Cache",
+          [=] {
+              auto& renderer = game->getRenderer();
+              renderer.cacheStaticDraws = !renderer.cacheStaticDraws;
+          }}},
         kDebugFont, kDebugEntryHeight);
 
     menu->offset = kDebugMenuOffset;
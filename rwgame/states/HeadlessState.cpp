@@ -0,0 +1,91 @@
+#include "HeadlessState.hpp"
+#include "RWGame.hpp"
+
+#include <ai/PlayerController.hpp>
+#include <objects/CharacterObject.hpp>
+
+#include <iomanip>
+#include <iostream>
+
+namespace {
+/// Real seconds between progress reports
+constexpr double kReportInterval = 5.0;
+
+double secondsSince(std::chrono::steady_clock::time_point time) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         time)
+        .count();
+}
+}
+
+HeadlessState::HeadlessState(RWGame* game, float duration)
+    : State(game)
+    , duration(duration)
+    , simulatedTime(0.f)
+    , ticks(0)
+    , started(false)
+    , reportTicks(0) {
+}
+
+void HeadlessState::enter() {
+    if (started) {
+        return;
+    }
+    started = true;
+
+    game->startScript("data/main.scm");
+    if (game->getScriptVM()) {
+        game->getScriptVM()->startThread(0);
+    }
+
+    startTime = reportTime = std::chrono::steady_clock::now();
+    std::cout << "Running headless" << std::endl;
+}
+
+void HeadlessState::exit() {
+    double elapsed = secondsSince(startTime);
+    std::cout << "Results =============\n"
+              << "Ticks: " << ticks << "\n"
+              << "Simulated: " << simulatedTime << " seconds\n"
+              << "Elapsed: " << std::setprecision(3) << elapsed
+              << " seconds\n"
+              << "Tick rate: " << (ticks / elapsed) << " ticks/s ("
+              << (simulatedTime / elapsed) << "x realtime)" << std::endl;
+}
+
+void HeadlessState::tick(float dt) {
+    ticks++;
+    simulatedTime += dt;
+
+    double elapsed = secondsSince(reportTime);
+    if (elapsed >= kReportInterval) {
+        auto reported = ticks - reportTicks;
+        std::cout << std::setprecision(3) << simulatedTime << "s: "
+                  << (reported / elapsed) << " ticks/s ("
+                  << (reported * dt / elapsed) << "x realtime)" << std::endl;
+        reportTime = std::chrono::steady_clock::now();
+        reportTicks = ticks;
+    }
+
+    if (duration > 0.f && simulatedTime >= duration) {
+        done();
+    }
+}
+
+bool HeadlessState::shouldWorldUpdate() {
+    return true;
+}
+
+const ViewCamera& HeadlessState::getCamera() {
+    auto player = game->getPlayer();
+    if (player && player->getCharacter()) {
+        auto character = player->getCharacter();
+        auto rotation = character->getRotation();
+        camera.position = character->getPosition() +
+                          rotation * glm::vec3(0.f, -4.f, 2.f);
+        camera.rotation =
+            rotation * glm::angleAxis(glm::half_pi<float>(),
+                                      glm::vec3(0.f, 0.f, 1.f));
+    }
+    return camera;
+}
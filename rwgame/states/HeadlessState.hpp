@@ -0,0 +1,39 @@
+#ifndef _RWGAME_HEADLESSSTATE_HPP_
+#define _RWGAME_HEADLESSSTATE_HPP_
+
+#include "State.hpp"
+
+#include <chrono>
+
+/**
+ * Runs the game's scripts without a window, reporting how fast the
+ * simulation ticks. The camera follows the player so the world around
+ * them is populated as it would be when playing.
+ */
+class HeadlessState : public State {
+    ViewCamera camera;
+
+    /// Game seconds to run for, or 0 to run until stopped
+    float duration;
+    float simulatedTime;
+    uint64_t ticks;
+    bool started;
+
+    std::chrono::steady_clock::time_point startTime;
+    std::chrono::steady_clock::time_point reportTime;
+    uint64_t reportTicks;
+
+public:
+    HeadlessState(RWGame* game, float duration);
+
+    virtual void enter();
+    virtual void exit();
+
+    virtual void tick(float dt);
+
+    virtual bool shouldWorldUpdate();
+
+    const ViewCamera& getCamera();
+};
+
+#endif
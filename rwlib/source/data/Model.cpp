@@ -3,10 +3,13 @@
 
 #include <glm/gtc/matrix_transform.hpp>
 
-Model::Geometry::Geometry() : flags(0) {
+Model::Geometry::Geometry() : EBO(0), flags(0) {
 }
 
 Model::Geometry::~Geometry() {
+    if (EBO != 0) {
+        glDeleteBuffers(1, &EBO);
+    }
 }
 
 ModelFrame::ModelFrame(unsigned int index, ModelFrame* parent, glm::mat3 dR,
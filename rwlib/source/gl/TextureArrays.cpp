@@ -0,0 +1,116 @@
+#include <gl/TextureArrays.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+constexpr GLsizeiptr TextureArrays::kArrayBytes;
+constexpr GLsizei TextureArrays::kMaxLayers;
+constexpr GLsizei TextureArrays::kInitialLayers;
+
+TextureArrays::TextureArrays(GLsizeiptr arrayBytes)
+    : m_arrayBytes(arrayBytes) {
+}
+
+TextureArrays::~TextureArrays() {
+    for (auto& array : m_arrays) {
+        glDeleteTextures(1, &array.texture);
+    }
+}
+
+GLsizei TextureArrays::getLayerCapacity(const glm::ivec2& size) const {
+    // Every texture is stored as RGBA
+    GLsizeiptr bytes = GLsizeiptr(size.x) * size.y * 4;
+    if (bytes <= 0) {
+        return 0;
+    }
+    return static_cast<GLsizei>(
+        std::min(m_arrayBytes / bytes, GLsizeiptr(kMaxLayers)));
+}
+
+TextureArrays::Layer TextureArrays::add(const glm::ivec2& size,
+                                        const Sampling& sampling,
+                                        GLenum format, GLenum type,
+                                        const void* pixels) {
+    auto capacity = getLayerCapacity(size);
+    if (capacity < 2) {
+        return {0, 0};
+    }
+
+    auto it = std::find_if(
+        m_arrays.begin(), m_arrays.end(), [&](const Array& array) {
+            return array.size == size && array.sampling == sampling &&
+                   array.layers < array.capacity;
+        });
+
+    if (it == m_arrays.end()) {
+        auto allocated = std::min(kInitialLayers, capacity);
+        Array array{0, size, sampling, 0, allocated, capacity, false};
+        glGenTextures(1, &array.texture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, array.texture);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, size.x, size.y,
+                     allocated, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER,
+                        GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER,
+                        sampling.magFilter);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S,
+                        sampling.wrapS);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T,
+                        sampling.wrapT);
+
+        m_arrays.push_back(array);
+        it = m_arrays.end() - 1;
+    } else if (it->layers == it->allocated) {
+        grow(*it);
+    } else {
+        glBindTexture(GL_TEXTURE_2D_ARRAY, it->texture);
+    }
+
+    auto layer = it->layers++;
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, size.x, size.y, 1,
+                    format, type, pixels);
+    it->dirty = true;
+
+    return {it->texture, layer};
+}
+
+void TextureArrays::grow(Array& array) {
+    auto allocated = std::min(array.allocated * 2, array.capacity);
+    auto layerBytes = size_t(array.size.x) * array.size.y * 4;
+
+    // Respecifying the texture discards its layers, so they are read back
+    // first. This only happens a few times per array while loading.
+    std::vector<uint8_t> pixels(layerBytes * allocated);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, array.texture);
+    glGetTexImage(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                  pixels.data());
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, array.size.x, array.size.y,
+                 allocated, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+    array.allocated = allocated;
+    // The other levels still have the old depth until they're remade
+    array.dirty = true;
+}
+
+GLsizeiptr TextureArrays::getAllocatedBytes() const {
+    GLsizeiptr bytes = 0;
+    for (auto& array : m_arrays) {
+        bytes += GLsizeiptr(array.size.x) * array.size.y * 4 * array.allocated;
+    }
+    return bytes;
+}
+
+bool TextureArrays::generateMipmaps() {
+    bool generated = false;
+    for (auto& array : m_arrays) {
+        if (array.dirty) {
+            glBindTexture(GL_TEXTURE_2D_ARRAY, array.texture);
+            glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+            array.dirty = false;
+            generated = true;
+        }
+    }
+    return generated;
+}
@@ -0,0 +1,111 @@
+#pragma once
+#ifndef _TEXTUREARRAYS_HPP_
+#define _TEXTUREARRAYS_HPP_
+#include <gl/gl_core_3_3.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/**
+ * Packs textures into the layers of shared GL_TEXTURE_2D_ARRAYs, so that
+ * draws using any of them bind the same texture and can be sorted and
+ * instanced together, with the layer given per draw.
+ *
+ * Every layer of an array has the same size and sampling state, so textures
+ * are grouped by both. Wrapping works as it does for a 2D texture, and
+ * texture coordinates are unchanged.
+ *
+ * Arrays start with a few layers and double as they fill, up to the
+ * capacity of kArrayBytes, so sizes and samplings with only a handful of
+ * textures don't reserve a full array. The array keeps its name when it
+ * grows, so layers already handed out stay valid.
+ *
+ * The mipmaps of arrays given new layers are made by generateMipmaps,
+ * rather than once for each layer.
+ */
+class TextureArrays {
+public:
+    /// Bytes of level 0 to allocate for each array
+    static constexpr GLsizeiptr kArrayBytes = 4 * 1024 * 1024;
+    /// The fewest layers GL_MAX_ARRAY_TEXTURE_LAYERS can be
+    static constexpr GLsizei kMaxLayers = 256;
+    /// Layers allocated for a new array
+    static constexpr GLsizei kInitialLayers = 4;
+
+    /// How a texture is filtered and wrapped
+    struct Sampling {
+        GLenum magFilter;
+        GLenum wrapS;
+        GLenum wrapT;
+
+        bool operator==(const Sampling& other) const {
+            return magFilter == other.magFilter && wrapS == other.wrapS &&
+                   wrapT == other.wrapT;
+        }
+    };
+
+    /// Where a texture was packed
+    struct Layer {
+        /// The array, or 0 if the texture wasn't packed
+        GLuint texture;
+        GLint layer;
+    };
+
+    explicit TextureArrays(GLsizeiptr arrayBytes = kArrayBytes);
+
+    ~TextureArrays();
+
+    TextureArrays(const TextureArrays&) = delete;
+    TextureArrays& operator=(const TextureArrays&) = delete;
+
+    /**
+     * @brief Copies a texture into a free layer of an array
+     * @param format,type Describe pixels as they do for glTexImage2D
+     * @return The layer, with a texture of 0 if arrays of size would hold
+     * fewer than two layers
+     */
+    Layer add(const glm::ivec2& size, const Sampling& sampling, GLenum format,
+              GLenum type, const void* pixels);
+
+    /**
+     * @brief Makes the mipmaps of arrays given layers since the last call
+     * @return true if any were made
+     */
+    bool generateMipmaps();
+
+    /**
+     * @return How many layers an array of textures of size holds at most
+     */
+    GLsizei getLayerCapacity(const glm::ivec2& size) const;
+
+    size_t getArrayCount() const {
+        return m_arrays.size();
+    }
+
+    /**
+     * @return Bytes of level 0 allocated for every array
+     */
+    GLsizeiptr getAllocatedBytes() const;
+
+private:
+    struct Array {
+        GLuint texture;
+        glm::ivec2 size;
+        Sampling sampling;
+        GLsizei layers;
+        /// Layers the texture has room for
+        GLsizei allocated;
+        /// Layers it may grow to
+        GLsizei capacity;
+        /// Needs its mipmaps made
+        bool dirty;
+    };
+
+    /// Doubles the layers of array, keeping those in use
+    void grow(Array& array);
+
+    GLsizeiptr m_arrayBytes;
+    std::vector<Array> m_arrays;
+};
+
+#endif
@@ -6,11 +6,15 @@
 
 /**
  * Stores a handle and metadata about a loaded texture.
+ *
+ * Textures packed into a TextureArrays are a layer of a
+ * GL_TEXTURE_2D_ARRAY, the name is then the array's.
  */
 class TextureData {
 public:
-    TextureData(GLuint name, const glm::ivec2& dims, bool alpha)
-        : texName(name), size(dims), hasAlpha(alpha) {
+    TextureData(GLuint name, const glm::ivec2& dims, bool alpha,
+                GLint layer = -1)
+        : texName(name), size(dims), hasAlpha(alpha), arrayLayer(layer) {
     }
 
     GLuint getName() const {
@@ -25,15 +29,23 @@ public:
         return hasAlpha;
     }
 
+    /**
+     * @return The layer of the array, or -1 for a GL_TEXTURE_2D
+     */
+    GLint getLayer() const {
+        return arrayLayer;
+    }
+
     typedef std::shared_ptr<TextureData> Handle;
 
     static Handle create(GLuint name, const glm::ivec2& size,
-                         bool transparent) {
-        return Handle(new TextureData(name, size, transparent));
+                         bool transparent, GLint layer = -1) {
+        return Handle(new TextureData(name, size, transparent, layer));
     }
 
 private:
     GLuint texName;
     glm::ivec2 size;
     bool hasAlpha;
+    GLint arrayLayer;
 };
@@ -126,6 +126,7 @@ int ogl_ext_ARB_robust_buffer_access_behavior = 0;
 int ogl_ext_ARB_stencil_texturing = 0;
 int ogl_ext_ARB_texture_query_levels = 0;
 int ogl_ext_ARB_texture_storage_multisample = 0;
+int ogl_ext_ARB_buffer_storage = 0;
 int ogl_ext_KHR_debug = 0;
 
 // Extension: ARB_ES2_compatibility
@@ -380,6 +381,10 @@ static void CODEGEN_FUNCPTR Switch_TexStorage2DMultisample(GLenum target, GLsize
 typedef void (CODEGEN_FUNCPTR *PFN_PTRC_GLTEXSTORAGE3DMULTISAMPLEPROC)(GLenum, GLsizei, GLenum, GLsizei, GLsizei, GLsizei, GLboolean);
 static void CODEGEN_FUNCPTR Switch_TexStorage3DMultisample(GLenum target, GLsizei samples, GLenum internalformat, GLsizei width, GLsizei height, GLsizei depth, GLboolean fixedsamplelocations);
 
+// Extension: ARB_buffer_storage
+typedef void (CODEGEN_FUNCPTR *PFN_PTRC_GLBUFFERSTORAGEPROC)(GLenum, GLsizeiptr, const void *, GLbitfield);
+static void CODEGEN_FUNCPTR Switch_BufferStorage(GLenum target, GLsizeiptr size, const void * data, GLbitfield flags);
+
 // Extension: KHR_debug
 typedef void (CODEGEN_FUNCPTR *PFN_PTRC_GLDEBUGMESSAGECALLBACKPROC)(GLDEBUGPROC, const void *);
 static void CODEGEN_FUNCPTR Switch_DebugMessageCallback(GLDEBUGPROC callback, const void * userParam);
@@ -1259,6 +1264,9 @@ PFN_PTRC_GLINVALIDATETEXSUBIMAGEPROC _ptrc_glInvalidateTexSubImage = Switch_Inva
 PFN_PTRC_GLTEXSTORAGE2DMULTISAMPLEPROC _ptrc_glTexStorage2DMultisample = Switch_TexStorage2DMultisample;
 PFN_PTRC_GLTEXSTORAGE3DMULTISAMPLEPROC _ptrc_glTexStorage3DMultisample = Switch_TexStorage3DMultisample;
 
+// Extension: ARB_buffer_storage
+PFN_PTRC_GLBUFFERSTORAGEPROC _ptrc_glBufferStorage = Switch_BufferStorage;
+
 // Extension: KHR_debug
 PFN_PTRC_GLDEBUGMESSAGECALLBACKPROC _ptrc_glDebugMessageCallback = Switch_DebugMessageCallback;
 PFN_PTRC_GLDEBUGMESSAGECONTROLPROC _ptrc_glDebugMessageControl = Switch_DebugMessageControl;
@@ -2333,6 +2341,14 @@ static void CODEGEN_FUNCPTR Switch_TexStorage3DMultisample(GLenum target, GLsize
 }
 
 
+// Extension: ARB_buffer_storage
+static void CODEGEN_FUNCPTR Switch_BufferStorage(GLenum target, GLsizeiptr size, const void * data, GLbitfield flags)
+{
+	_ptrc_glBufferStorage = (PFN_PTRC_GLBUFFERSTORAGEPROC)IntGetProcAddress("glBufferStorage");
+	_ptrc_glBufferStorage(target, size, data, flags);
+}
+
+
 // Extension: KHR_debug
 static void CODEGEN_FUNCPTR Switch_DebugMessageCallback(GLDEBUGPROC callback, const void * userParam)
 {
@@ -4523,6 +4539,7 @@ static void ClearExtensionVariables()
 	ogl_ext_ARB_stencil_texturing = 0;
 	ogl_ext_ARB_texture_query_levels = 0;
 	ogl_ext_ARB_texture_storage_multisample = 0;
+	ogl_ext_ARB_buffer_storage = 0;
 	ogl_ext_KHR_debug = 0;
 }
 
@@ -4532,7 +4549,7 @@ typedef struct ogl_MapTable_s
 	int *extVariable;
 }ogl_MapTable;
 
-static ogl_MapTable g_mappingTable[32] = 
+static ogl_MapTable g_mappingTable[33] = 
 {
 	{"GL_EXT_texture_compression_s3tc", &ogl_ext_EXT_texture_compression_s3tc},
 	{"GL_EXT_texture_sRGB", &ogl_ext_EXT_texture_sRGB},
@@ -4565,12 +4582,13 @@ static ogl_MapTable g_mappingTable[32] =
 	{"GL_ARB_stencil_texturing", &ogl_ext_ARB_stencil_texturing},
 	{"GL_ARB_texture_query_levels", &ogl_ext_ARB_texture_query_levels},
 	{"GL_ARB_texture_storage_multisample", &ogl_ext_ARB_texture_storage_multisample},
+	{"GL_ARB_buffer_storage", &ogl_ext_ARB_buffer_storage},
 	{"GL_KHR_debug", &ogl_ext_KHR_debug},
 };
 
 static void LoadExtByName(const char *extensionName)
 {
-	ogl_MapTable *tableEnd = &g_mappingTable[32];
+	ogl_MapTable *tableEnd = &g_mappingTable[33];
 	ogl_MapTable *entry = &g_mappingTable[0];
 	for(; entry != tableEnd; ++entry)
 	{
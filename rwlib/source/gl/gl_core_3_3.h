@@ -186,6 +186,7 @@ typedef unsigned int GLhandleARB;
 		extern int ogl_ext_ARB_stencil_texturing;
 		extern int ogl_ext_ARB_texture_query_levels;
 		extern int ogl_ext_ARB_texture_storage_multisample;
+		extern int ogl_ext_ARB_buffer_storage;
 		extern int ogl_ext_KHR_debug;
 		
 		// Extension: EXT_texture_compression_s3tc
@@ -507,6 +508,15 @@ typedef unsigned int GLhandleARB;
 		// Extension: ARB_stencil_texturing
 		#define GL_DEPTH_STENCIL_TEXTURE_MODE    0x90EA
 		
+		// Extension: ARB_buffer_storage
+		#define GL_BUFFER_IMMUTABLE_STORAGE      0x821F
+		#define GL_BUFFER_STORAGE_FLAGS          0x8220
+		#define GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT 0x00004000
+		#define GL_CLIENT_STORAGE_BIT            0x0200
+		#define GL_DYNAMIC_STORAGE_BIT           0x0100
+		#define GL_MAP_COHERENT_BIT              0x0080
+		#define GL_MAP_PERSISTENT_BIT            0x0040
+		
 		// Extension: KHR_debug
 		#define GL_BUFFER                        0x82E0
 		#define GL_CONTEXT_FLAG_DEBUG_BIT        0x00000002
@@ -1625,6 +1635,10 @@ typedef unsigned int GLhandleARB;
 		extern void (CODEGEN_FUNCPTR *_ptrc_glTexStorage3DMultisample)(GLenum target, GLsizei samples, GLenum internalformat, GLsizei width, GLsizei height, GLsizei depth, GLboolean fixedsamplelocations);
 		#define glTexStorage3DMultisample _ptrc_glTexStorage3DMultisample
 		
+		// Extension: ARB_buffer_storage
+		extern void (CODEGEN_FUNCPTR *_ptrc_glBufferStorage)(GLenum target, GLsizeiptr size, const void * data, GLbitfield flags);
+		#define glBufferStorage _ptrc_glBufferStorage
+		
 		// Extension: KHR_debug
 		extern void (CODEGEN_FUNCPTR *_ptrc_glDebugMessageCallback)(GLDEBUGPROC callback, const void * userParam);
 		#define glDebugMessageCallback _ptrc_glDebugMessageCallback
@@ -1,38 +1,300 @@
 #include <job/WorkContext.hpp>
 
+#include <algorithm>
+
+namespace {
+/// The worker running on the current thread, if any
+thread_local LoadWorker* tCurrentWorker = nullptr;
+
+/// Chunks of a parallelFor, claimed by whichever thread gets there first
+struct ParallelRange {
+    std::function<void(size_t, size_t, size_t)> function;
+    size_t count;
+    size_t grain;
+    size_t chunks;
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> done{0};
+    std::mutex mutex;
+    std::condition_variable finished;
+
+    /// Runs chunks until none are left unclaimed
+    void run() {
+        size_t chunk;
+        while ((chunk = next++) < chunks) {
+            auto begin = chunk * grain;
+            function(chunk, begin, std::min(count, begin + grain));
+            if (++done == chunks) {
+                std::lock_guard<std::mutex> guard(mutex);
+                finished.notify_all();
+            }
+        }
+    }
+};
+
+/// Helps with a parallelFor from the pool. Helpers that start after every
+/// chunk has been claimed have nothing to do.
+class ParallelForJob : public WorkJob {
+    std::shared_ptr<ParallelRange> _range;
+
+public:
+    ParallelForJob(WorkContext* context, std::shared_ptr<ParallelRange> range)
+        : WorkJob(context, Critical), _range(std::move(range)) {
+    }
+
+    void work() override {
+        _range->run();
+    }
+};
+}
+
 void LoadWorker::start() {
-    while (_running) {
-        _context->workNext();
-        std::this_thread::yield();
+    tCurrentWorker = this;
+
+    while (_context->isRunning()) {
+        auto job = _context->nextJob(this);
+        if (job) {
+            _context->workJob(job);
+        }
+    }
+
+    tCurrentWorker = nullptr;
+}
+
+WorkJob* LoadWorker::pop(WorkJob::Priority priority) {
+    std::lock_guard<std::mutex> guard(_mutex);
+    auto& jobs = _jobs[priority];
+    if (jobs.empty()) {
+        return nullptr;
+    }
+    auto job = jobs.front();
+    jobs.pop_front();
+    return job;
+}
+
+WorkJob* LoadWorker::steal(WorkJob::Priority priority) {
+    std::lock_guard<std::mutex> guard(_mutex);
+    auto& jobs = _jobs[priority];
+    if (jobs.empty()) {
+        return nullptr;
+    }
+    auto job = jobs.back();
+    jobs.pop_back();
+    return job;
+}
+
+WorkContext::WorkContext(size_t threads)
+    : _running(true), _pending(0), _nextWorker(0) {
+    for (auto& queued : _queued) {
+        queued = 0;
+    }
+
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // All of the workers must exist before any of them can steal
+    for (size_t i = 0; i < threads; ++i) {
+        _workers.emplace_back(new LoadWorker(this, i));
+    }
+    for (auto& worker : _workers) {
+        worker->_thread = std::thread(&LoadWorker::start, worker.get());
     }
 }
 
-void WorkContext::workNext() {
-    WorkJob* j = nullptr;
+void WorkContext::queueJob(WorkJob* job) {
+    if (!_running) {
+        discardJob(job);
+        return;
+    }
+
+    ++_pending;
 
+    auto worker = tCurrentWorker;
+    if (worker == nullptr || worker->getContext() != this) {
+        worker = _workers[_nextWorker++ % _workers.size()].get();
+    }
+
+    auto priority = job->getPriority();
     {
-        std::lock_guard<std::mutex> guard(_inMutex);
+        // Count the job while it can't be taken, so a worker that takes
+        // it never sees the count before it was incremented
+        std::lock_guard<std::mutex> guard(worker->_mutex);
+        worker->_jobs[priority].push_back(job);
+        ++_queued[priority];
+    }
 
-        if (!_workQueue.empty()) {
-            j = _workQueue.front();
-            _workQueue.pop();
+    // Take the lock so the wakeup can't slip in between a worker
+    // checking for work and going to sleep.
+    std::lock_guard<std::mutex> guard(_sleepMutex);
+    _wakeCondition.notify_one();
+}
+
+void WorkContext::stop() {
+    // Stop serving the queue.
+    {
+        std::lock_guard<std::mutex> guard(_sleepMutex);
+        _running = false;
+        _wakeCondition.notify_all();
+    }
+
+    // Workers steal from each other until they notice, so every one must
+    // have stopped before any is destroyed
+    for (auto& worker : _workers) {
+        if (worker->_thread.joinable()) {
+            worker->_thread.join();
         }
     }
 
-    if (j == nullptr) return;
+    for (auto& worker : _workers) {
+        for (auto& jobs : worker->_jobs) {
+            for (auto job : jobs) {
+                discardJob(job);
+            }
+            jobs.clear();
+        }
+    }
+    while (!_completeQueue.empty()) {
+        discardJob(_completeQueue.front());
+        _completeQueue.pop();
+    }
 
-    j->work();
+    for (auto& queued : _queued) {
+        queued = 0;
+    }
+    _pending = 0;
+    _workers.clear();
+}
+
+bool WorkContext::hasQueuedJobs() const {
+    for (auto& queued : _queued) {
+        if (queued > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+WorkJob* WorkContext::nextJob(LoadWorker* worker) {
+    while (_running) {
+        for (int p = 0; p < WorkJob::PriorityCount; ++p) {
+            if (_queued[p] == 0) {
+                continue;
+            }
+            auto priority = static_cast<WorkJob::Priority>(p);
+            auto job = worker->pop(priority);
+            for (size_t i = 1; job == nullptr && i < _workers.size(); ++i) {
+                auto victim = (worker->getIndex() + i) % _workers.size();
+                job = _workers[victim]->steal(priority);
+            }
+            if (job) {
+                --_queued[p];
+                return job;
+            }
+        }
+
+        std::unique_lock<std::mutex> lock(_sleepMutex);
+        _wakeCondition.wait(lock,
+                            [&] { return hasQueuedJobs() || !_running; });
+    }
+    return nullptr;
+}
+
+void WorkContext::workJob(WorkJob* job) {
+    if (!job->isCancelled()) {
+        job->work();
+    }
 
     std::lock_guard<std::mutex> guard(_outMutex);
-    _completeQueue.push(j);
+    _completeQueue.push(job);
 }
 
 void WorkContext::update() {
-    std::lock_guard<std::mutex> guard(_outMutex);
-    while (!_completeQueue.empty()) {
-        WorkJob* j = _completeQueue.front();
-        _completeQueue.pop();
-        j->complete();
-        delete j;
+    update(std::chrono::steady_clock::duration::max());
+}
+
+size_t WorkContext::update(std::chrono::steady_clock::duration timeBudget,
+                           size_t byteBudget) {
+    auto start = std::chrono::steady_clock::now();
+    size_t bytes = 0;
+
+    while (true) {
+        WorkJob* j = nullptr;
+        {
+            std::lock_guard<std::mutex> guard(_outMutex);
+            if (_completeQueue.empty()) {
+                return 0;
+            }
+            j = _completeQueue.front();
+            _completeQueue.pop();
+        }
+
+        // Don't hold the lock while completing, so workers aren't blocked
+        if (!j->isCancelled()) {
+            bytes += j->getCompleteCost();
+        }
+        finishJob(j);
+
+        if (bytes >= byteBudget ||
+            std::chrono::steady_clock::now() - start >= timeBudget) {
+            break;
+        }
+    }
+
+    return getCompleteCount();
+}
+
+void WorkContext::finishJob(WorkJob* job) {
+    bool cancelled = job->isCancelled();
+    if (!cancelled) {
+        job->complete();
+    }
+
+    for (auto dependent : job->_dependents) {
+        if (cancelled) {
+            dependent->_dependencyCancelled = true;
+        }
+        if (--dependent->_waitCount == 0) {
+            queueJob(dependent);
+        }
+    }
+
+    delete job;
+    --_pending;
+}
+
+void WorkContext::discardJob(WorkJob* job) {
+    for (auto dependent : job->_dependents) {
+        dependent->_dependencyCancelled = true;
+        if (--dependent->_waitCount == 0) {
+            discardJob(dependent);
+        }
+    }
+    delete job;
+}
+
+void WorkContext::parallelFor(
+    size_t count, size_t grain,
+    const std::function<void(size_t, size_t, size_t)>& f) {
+    if (count == 0) {
+        return;
     }
+    grain = std::max<size_t>(1, grain);
+
+    auto range = std::make_shared<ParallelRange>();
+    range->function = f;
+    range->count = count;
+    range->grain = grain;
+    range->chunks = (count + grain - 1) / grain;
+
+    auto helpers = std::min(_workers.size(), range->chunks - 1);
+    for (size_t i = 0; i < helpers; ++i) {
+        queueJob(new ParallelForJob(this, range));
+    }
+
+    range->run();
+
+    // Wait for the chunks still running on the pool
+    std::unique_lock<std::mutex> lock(range->mutex);
+    range->finished.wait(lock,
+                         [&] { return range->done == range->chunks; });
 }
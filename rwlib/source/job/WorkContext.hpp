@@ -1,32 +1,45 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <functional>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <queue>
 #include <thread>
+#include <vector>
 
 class WorkContext;
 
-class LoadWorker {
-    WorkContext* _context;
+/**
+ * @brief Allows a group of jobs to be withdrawn after they are queued.
+ *
+ * Jobs sharing a cancelled token are skipped if they haven't started, and
+ * never have complete() called. Long running jobs may poll isCancelled().
+ */
+class CancelToken {
+    std::atomic<bool> cancelled;
 
 public:
-    std::atomic<bool> _running;
-    std::thread _thread;
-    void start();
+    CancelToken() : cancelled(false) {
+    }
 
-    LoadWorker(WorkContext* context)
-        : _context(context)
-        , _running(true)
-        , _thread(std::bind(&LoadWorker::start, this)) {
+    void cancel() {
+        cancelled = true;
     }
 
-    ~LoadWorker() {
-        _running = false;
-        _thread.join();
+    bool isCancelled() const {
+        return cancelled;
+    }
+
+    typedef std::shared_ptr<CancelToken> Handle;
+
+    static Handle create() {
+        return std::make_shared<CancelToken>();
     }
 };
 
@@ -34,10 +47,36 @@ public:
  * @brief Interface for background work
  */
 class WorkJob {
+public:
+    /// Scheduling classes, lower values are run first
+    enum Priority {
+        Critical,   ///< Needed for the frame being drawn
+        Streaming,  ///< Needed soon, e.g. objects coming into range
+        Prefetch,   ///< Speculative loading
+        Idle,       ///< Only run when there's nothing else to do
+        PriorityCount
+    };
+
+private:
     WorkContext* _context;
+    Priority _priority;
+    CancelToken::Handle _cancelToken;
+
+    /// Number of jobs that must complete before this one is queued
+    std::atomic<size_t> _waitCount;
+    /// Jobs waiting on this one
+    std::vector<WorkJob*> _dependents;
+    /// Set when a job this one depends on was cancelled
+    std::atomic<bool> _dependencyCancelled;
+
+    friend class WorkContext;
 
 public:
-    WorkJob(WorkContext* context) : _context(context) {
+    WorkJob(WorkContext* context, Priority priority = Streaming)
+        : _context(context)
+        , _priority(priority)
+        , _waitCount(0)
+        , _dependencyCancelled(false) {
     }
 
     virtual ~WorkJob() {
@@ -51,51 +90,221 @@ public:
         return _context;
     }
 
+    Priority getPriority() const {
+        return _priority;
+    }
+
+    void setPriority(Priority priority) {
+        _priority = priority;
+    }
+
+    void setCancelToken(const CancelToken::Handle& token) {
+        _cancelToken = token;
+    }
+
+    bool isCancelled() const {
+        return _dependencyCancelled ||
+               (_cancelToken && _cancelToken->isCancelled());
+    }
+
+    /**
+     * @brief Makes job wait for this job to complete before it is queued
+     * @param job The dependent job, owned by the context from here on
+     * @return job, so that chains can be written as a->then(b)->then(c)
+     *
+     * Dependencies must be added before this job is queued, or by the
+     * thread calling update() before this job completes. The dependent
+     * must not be queued directly. It is queued once complete()
+     * has run for every job it depends on. If one of those jobs is
+     * cancelled, the dependent is cancelled too.
+     */
+    WorkJob* then(WorkJob* job) {
+        job->_waitCount++;
+        _dependents.push_back(job);
+        return job;
+    }
+
     virtual void work() = 0;
     virtual void complete() {
     }
+
+    /**
+     * @brief getCompleteCost
+     * @return Roughly how many bytes complete() will upload, for budgeting
+     */
+    virtual size_t getCompleteCost() const {
+        return 0;
+    }
 };
 
 /**
- * @brief A worker queue that runs work in the background.
+ * @brief A single thread in the WorkContext pool.
+ *
+ * Each worker owns a deque of jobs, it takes work from the front of its own
+ * deque and steals from the back of the other workers' deques when empty.
+ */
+class LoadWorker {
+    WorkContext* _context;
+    size_t _index;
+
+public:
+    std::mutex _mutex;
+    std::deque<WorkJob*> _jobs[WorkJob::PriorityCount];
+    std::thread _thread;
+
+    void start();
+
+    LoadWorker(WorkContext* context, size_t index)
+        : _context(context), _index(index) {
+    }
+
+    ~LoadWorker() {
+        if (_thread.joinable()) {
+            _thread.join();
+        }
+    }
+
+    WorkContext* getContext() const {
+        return _context;
+    }
+
+    size_t getIndex() const {
+        return _index;
+    }
+
+    /**
+     * @brief Removes a job from the front of this worker's queue
+     * @return The job, or nullptr if the queue was empty
+     */
+    WorkJob* pop(WorkJob::Priority priority);
+
+    /**
+     * @brief Removes a job from the back of this worker's queue
+     * @return The job, or nullptr if the queue was empty
+     */
+    WorkJob* steal(WorkJob::Priority priority);
+};
+
+/**
+ * @brief A worker pool that runs work in the background.
  *
  * Work is added with queueJob, once it completes the job is added
  * to the _completeQueue to be finalised on the "main" thread.
+ *
+ * Jobs queued from outside the pool are distributed between the workers,
+ * jobs queued from inside a job go to the current worker's queue. Idle
+ * workers steal from the others, and sleep when there is no work at all.
+ * Higher priority jobs are always taken first, from any worker.
+ *
+ * Cancelled jobs are deleted without having work() or complete() called.
+ * So are jobs still waiting when the context stops, and jobs queued after.
  */
 class WorkContext {
-    std::mutex _inMutex;
     std::mutex _outMutex;
-
-    std::queue<WorkJob*> _workQueue;
     std::queue<WorkJob*> _completeQueue;
 
-    // Construct the worker last, so that it may use the queues
+    std::mutex _sleepMutex;
+    std::condition_variable _wakeCondition;
+    std::atomic<bool> _running;
+
+    /// Number of jobs waiting in the worker queues, for each priority
+    std::atomic<size_t> _queued[WorkJob::PriorityCount];
+    /// Number of jobs queued but not yet completed
+    std::atomic<size_t> _pending;
+    /// Worker that receives the next externally queued job
+    std::atomic<size_t> _nextWorker;
+
+    // Construct the workers last, so that they may use the queues
     // immediately after initialization.
-    std::unique_ptr<LoadWorker> _worker;
+    std::vector<std::unique_ptr<LoadWorker>> _workers;
 
 public:
-    WorkContext() : _worker(new LoadWorker(this)) {
+    /**
+     * @param threads The number of worker threads, 0 to match the hardware
+     */
+    WorkContext(size_t threads = 0);
+
+    ~WorkContext() {
+        stop();
     }
 
-    void queueJob(WorkJob* job) {
-        std::lock_guard<std::mutex> guard(_inMutex);
-        _workQueue.push(job);
+    void queueJob(WorkJob* job);
+
+    void queueJob(WorkJob* job, WorkJob::Priority priority) {
+        job->setPriority(priority);
+        queueJob(job);
     }
 
-    void stop() {
-        // Stop serving the queue.
-        _worker.reset(nullptr);
+    void stop();
+
+    size_t getWorkerCount() const {
+        return _workers.size();
     }
 
-    // Called by the worker thread - don't touch
-    void workNext();
+    // Called by the worker threads - don't touch
+    WorkJob* nextJob(LoadWorker* worker);
+    void workJob(WorkJob* job);
+    bool hasQueuedJobs() const;
+    bool isRunning() const {
+        return _running;
+    }
 
     bool isEmpty() {
-        std::lock_guard<std::mutex> guardIn(_inMutex);
-        std::lock_guard<std::mutex> guardOut(_outMutex);
-
-        return (_workQueue.size() + _completeQueue.size()) == 0;
+        return _pending == 0;
     }
 
+    /**
+     * @brief Completes every finished job on the calling thread
+     */
     void update();
+
+    /**
+     * @brief Completes finished jobs until a budget is spent
+     * @param timeBudget Stop once this much time has been spent
+     * @param byteBudget Stop once this many bytes have been completed
+     * @return The number of finished jobs left for the next update
+     *
+     * At least one job is completed per call so progress is always made.
+     */
+    size_t update(std::chrono::steady_clock::duration timeBudget,
+                  size_t byteBudget = std::numeric_limits<size_t>::max());
+
+    /**
+     * @return The number of finished jobs waiting for update()
+     */
+    size_t getCompleteCount() {
+        std::lock_guard<std::mutex> guard(_outMutex);
+        return _completeQueue.size();
+    }
+
+    /**
+     * @return The number of jobs that are queued, running or finished
+     */
+    size_t getPendingCount() const {
+        return _pending;
+    }
+
+    /**
+     * @brief Runs f over [0, count) in chunks of up to grain items
+     * @param f Called as f(chunk, begin, end) once for every chunk
+     *
+     * The calling thread works through the chunks alongside the pool, and
+     * this returns once every chunk has run. Chunks are numbered in order,
+     * so results can be gathered per chunk and merged deterministically.
+     * Must not be called from inside a job.
+     */
+    void parallelFor(size_t count, size_t grain,
+                     const std::function<void(size_t, size_t, size_t)>& f);
+
+private:
+    /**
+     * @brief Completes or discards a finished job, queuing its dependents
+     */
+    void finishJob(WorkJob* job);
+
+    /**
+     * @brief Deletes a job that will never run, along with the dependents
+     * that were only waiting on it
+     */
+    void discardJob(WorkJob* job);
 };
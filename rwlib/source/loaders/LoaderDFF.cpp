@@ -234,6 +234,10 @@ void LoaderDFF::readGeometry(Model *model, const RWBStream &stream) {
         }
     }
 
+    if (!upload) {
+        return;
+    }
+
     geom->dbuff.setFaceType(
         geom->facetype == Model::Triangles ? GL_TRIANGLES : GL_TRIANGLE_STRIP);
     geom->gbuff.uploadVertices(verts);
@@ -24,6 +24,8 @@ public:
 };
 
 class LoaderDFF {
+    bool upload;
+
     /**
      * @brief loads a Frame List chunk from stream into model.
      * @param model
@@ -48,6 +50,13 @@ class LoaderDFF {
     void readAtomic(Model* model, const RWBStream& stream);
 
 public:
+    /**
+     * @param upload Creates the GL buffers geometry is drawn from, which
+     * needs a GL context
+     */
+    explicit LoaderDFF(bool upload = true) : upload(upload) {
+    }
+
     Model* loadFromMemory(FileHandle file);
 };
 
@@ -1,6 +1,11 @@
 #include <loaders/LoaderIMG.hpp>
 
+#include <algorithm>
 #include <boost/algorithm/string/predicate.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace bip = boost::interprocess;
 
 LoaderIMG::LoaderIMG() : m_version(GTAIIIVC), m_assetCount(0) {
 }
@@ -37,6 +42,63 @@ bool LoaderIMG::load(const std::string& filename) {
     }
 }
 
+bool LoaderIMG::map() {
+    if (m_mapping) {
+        return true;
+    }
+
+    try {
+        bip::file_mapping file(m_archive.c_str(), bip::read_only);
+        m_mapping = std::make_shared<bip::mapped_region>(file,
+                                                         bip::copy_on_write);
+    } catch (bip::interprocess_exception& ex) {
+        std::cerr << "Failed to map IMG archive " << m_archive << ": "
+                  << ex.what() << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool LoaderIMG::isMapped() const {
+    return m_mapping != nullptr;
+}
+
+FileHandle LoaderIMG::openAsset(const LoaderIMGFile& asset) {
+    size_t offset = asset.offset * kIMGSectorSize;
+    size_t length = asset.size * kIMGSectorSize;
+
+    if (!m_mapping) {
+        FILE* fp = fopen(m_archive.c_str(), "rb");
+        if (!fp) {
+            return nullptr;
+        }
+
+        char* raw_data = new char[length];
+
+        fseek(fp, offset, SEEK_SET);
+        if (fread(raw_data, kIMGSectorSize, asset.size, fp) != asset.size) {
+            std::cerr << "Error reading asset " << asset.name << std::endl;
+        }
+
+        fclose(fp);
+        return std::make_shared<FileContentsInfo>(raw_data, length);
+    }
+
+    auto size = m_mapping->get_size();
+    if (offset >= size) {
+        std::cerr << "Asset " << asset.name << " is outside of " << m_archive
+                  << std::endl;
+        return nullptr;
+    }
+    // The last asset may not be padded out to a full sector
+    length = std::min(length, size - offset);
+
+    auto base = static_cast<char*>(m_mapping->get_address());
+    return std::make_shared<FileContentsInfo>(base + offset, length,
+                                              m_mapping);
+}
+
 /// Get the information of a asset in the examining archive
 bool LoaderIMG::findAssetInfo(const std::string& assetname,
                               LoaderIMGFile& out) {
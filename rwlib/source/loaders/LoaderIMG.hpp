@@ -2,10 +2,22 @@
 #ifndef _LOADERIMG_HPP_
 #define _LOADERIMG_HPP_
 
+#include <platform/FileHandle.hpp>
+
 #include <cstdint>
 #include <iostream>
+#include <memory>
 #include <vector>
 
+namespace boost {
+namespace interprocess {
+class mapped_region;
+}
+}
+
+/// Size of the sectors that archive offsets and sizes are measured in
+constexpr size_t kIMGSectorSize = 2048;
+
 /// \brief Points to one file within the archive
 class LoaderIMGFile {
 public:
@@ -36,6 +48,18 @@ public:
     /// appropriate
     bool load(const std::string& filename);
 
+    /// Map the archive's data into memory, so that assets can be opened
+    /// without reading or copying them. The mapping is private, writes to
+    /// an asset's memory are not written back to the archive.
+    bool map();
+
+    /// Returns true if the archive's data is mapped into memory
+    bool isMapped() const;
+
+    /// Returns a handle to the contents of an asset. If the archive is mapped
+    /// the handle points into the mapping, otherwise the asset is read.
+    FileHandle openAsset(const LoaderIMGFile& asset);
+
     /// Load a file from the archive to memory and pass a pointer to it
     /// Warning: Please delete[] the memory in the end.
     /// Warning: Returns NULL (0) if by any reason it can't load the file
@@ -59,6 +83,9 @@ private:
     std::string m_archive;  ///< Path to the archive being used (no extension)
 
     std::vector<LoaderIMGFile> m_assets;  ///< Asset info of the archive
+
+    /// The mapped archive data, shared with the FileHandles pointing into it
+    std::shared_ptr<boost::interprocess::mapped_region> m_mapping;
 };
 
 #endif  // LoaderIMG_h__
@@ -1,3 +1,4 @@
+#include <gl/TextureArrays.hpp>
 #include <gl/TextureData.hpp>
 #include <loaders/LoaderTXD.hpp>
 
@@ -40,8 +41,21 @@ void processPalette(uint32_t* fullColor, RW::BinaryStreamSection& rootSection) {
     }
 }
 
+GLenum getWrapMode(uint8_t wrap) {
+    switch (wrap) {
+        default:
+        case RW::BSTextureNative::WRAP_WRAP:
+            return GL_REPEAT;
+        case RW::BSTextureNative::WRAP_CLAMP:
+            return GL_CLAMP_TO_EDGE;
+        case RW::BSTextureNative::WRAP_MIRROR:
+            return GL_MIRRORED_REPEAT;
+    }
+}
+
 TextureData::Handle createTexture(RW::BSTextureNative& texNative,
-                                  RW::BinaryStreamSection& rootSection) {
+                                  RW::BinaryStreamSection& rootSection,
+                                  TextureArrays* arrays) {
     // TODO: Exception handling.
     if (texNative.platform != 8) {
         std::cerr << "Unsupported texture platform " << std::dec
@@ -66,23 +80,20 @@ TextureData::Handle createTexture(RW::BSTextureNative& texNative,
         return getErrorTexture();
     }
 
-    GLuint textureName = 0;
+    std::vector<uint32_t> fullColor;
+    const void* pixels = nullptr;
+    GLenum type = GL_UNSIGNED_BYTE, format = GL_RGBA;
 
     if (isPal8) {
-        std::vector<uint32_t> fullColor(texNative.width * texNative.height);
+        fullColor.resize(texNative.width * texNative.height);
 
         processPalette(fullColor.data(), rootSection);
 
-        glGenTextures(1, &textureName);
-        glBindTexture(GL_TEXTURE_2D, textureName);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, texNative.width,
-                     texNative.height, 0, GL_RGBA, GL_UNSIGNED_BYTE,
-                     fullColor.data());
+        pixels = fullColor.data();
     } else if (isFulc) {
         auto coldata = rootSection.raw() + sizeof(RW::BSTextureNative);
         coldata += sizeof(uint32_t);
 
-        GLenum type = GL_UNSIGNED_BYTE, format = GL_RGBA;
         switch (texNative.rasterformat) {
             case RW::BSTextureNative::FORMAT_1555:
                 format = GL_RGBA;
@@ -102,10 +113,7 @@ TextureData::Handle createTexture(RW::BSTextureNative& texNative,
                 break;
         }
 
-        glGenTextures(1, &textureName);
-        glBindTexture(GL_TEXTURE_2D, textureName);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, texNative.width,
-                     texNative.height, 0, format, type, coldata);
+        pixels = coldata;
     } else {
         return getErrorTexture();
     }
@@ -121,47 +129,38 @@ TextureData::Handle createTexture(RW::BSTextureNative& texNative,
             break;
     }
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
-                    GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, texFilter);
+    GLenum wrapS = getWrapMode(texNative.wrapU);
+    GLenum wrapT = getWrapMode(texNative.wrapV);
+    glm::ivec2 size(texNative.width, texNative.height);
 
-    GLenum texwrap = GL_REPEAT;
-    switch (texNative.wrapU) {
-        default:
-        case RW::BSTextureNative::WRAP_WRAP:
-            texwrap = GL_REPEAT;
-            break;
-        case RW::BSTextureNative::WRAP_CLAMP:
-            texwrap = GL_CLAMP_TO_EDGE;
-            break;
-        case RW::BSTextureNative::WRAP_MIRROR:
-            texwrap = GL_MIRRORED_REPEAT;
-            break;
+    if (arrays) {
+        auto layer = arrays->add(size, {texFilter, wrapS, wrapT}, format, type,
+                                 pixels);
+        if (layer.texture != 0) {
+            return TextureData::create(layer.texture, size, transparent,
+                                       layer.layer);
+        }
     }
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, texwrap);
 
-    switch (texNative.wrapV) {
-        default:
-        case RW::BSTextureNative::WRAP_WRAP:
-            texwrap = GL_REPEAT;
-            break;
-        case RW::BSTextureNative::WRAP_CLAMP:
-            texwrap = GL_CLAMP_TO_EDGE;
-            break;
-        case RW::BSTextureNative::WRAP_MIRROR:
-            texwrap = GL_MIRRORED_REPEAT;
-            break;
-    }
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, texwrap);
+    GLuint textureName = 0;
+    glGenTextures(1, &textureName);
+    glBindTexture(GL_TEXTURE_2D, textureName);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, texNative.width, texNative.height,
+                 0, format, type, pixels);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                    GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, texFilter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapS);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapT);
 
     glGenerateMipmap(GL_TEXTURE_2D);
 
-    return TextureData::create(textureName, {texNative.width, texNative.height},
-                               transparent);
+    return TextureData::create(textureName, size, transparent);
 }
 
-bool TextureLoader::loadFromMemory(FileHandle file,
-                                   TextureArchive& inTextures) {
+bool TextureLoader::loadFromMemory(FileHandle file, TextureArchive& inTextures,
+                                   TextureArrays* arrays) {
     auto data = file->data;
     RW::BinaryStreamSection root(data);
     /*auto texDict =*/root.readStructure<RW::BSTextureDictionary>();
@@ -179,7 +178,7 @@ bool TextureLoader::loadFromMemory(FileHandle file,
         std::transform(name.begin(), name.end(), name.begin(), ::tolower);
         std::transform(alpha.begin(), alpha.end(), alpha.begin(), ::tolower);
 
-        auto texture = createTexture(texNative, rootSection);
+        auto texture = createTexture(texNative, rootSection, arrays);
 
         inTextures[{name, alpha}] = texture;
 
@@ -197,8 +196,13 @@ bool TextureLoader::loadFromMemory(FileHandle file,
 LoadTextureArchiveJob::LoadTextureArchiveJob(WorkContext* context,
                                              FileIndex* index,
                                              TextureArchive& inTextures,
-                                             const std::string& file)
-    : WorkJob(context), archive(inTextures), fileIndex(index), _file(file) {
+                                             const std::string& file,
+                                             TextureArrays* arrays)
+    : WorkJob(context)
+    , archive(inTextures)
+    , fileIndex(index)
+    , _file(file)
+    , arrays(arrays) {
 }
 
 void LoadTextureArchiveJob::work() {
@@ -209,6 +213,6 @@ void LoadTextureArchiveJob::complete() {
     // TODO error status
     if (data) {
         TextureLoader loader;
-        loader.loadFromMemory(data, archive);
+        loader.loadFromMemory(data, archive, arrays);
     }
 }
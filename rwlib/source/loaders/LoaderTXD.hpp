@@ -16,10 +16,15 @@ typedef std::map<std::pair<std::string, std::string>, TextureData::Handle>
     TextureArchive;
 
 class FileIndex;
+class TextureArrays;
 
 class TextureLoader {
 public:
-    bool loadFromMemory(FileHandle file, TextureArchive& inTextures);
+    /**
+     * @param arrays If set, textures are packed into it where they can be
+     */
+    bool loadFromMemory(FileHandle file, TextureArchive& inTextures,
+                        TextureArrays* arrays = nullptr);
 };
 
 // TODO: refactor this interface to be more like ModelLoader so they can be
@@ -30,14 +35,20 @@ private:
     FileIndex* fileIndex;
     std::string _file;
     FileHandle data;
+    TextureArrays* arrays;
 
 public:
     LoadTextureArchiveJob(WorkContext* context, FileIndex* index,
-                          TextureArchive& inTextures, const std::string& file);
+                          TextureArchive& inTextures, const std::string& file,
+                          TextureArrays* arrays = nullptr);
 
     void work();
 
     void complete();
+
+    size_t getCompleteCost() const {
+        return data ? data->length : 0;
+    }
 };
 
 #endif
@@ -5,16 +5,26 @@
 
 /**
  * @brief Contains a pointer to a file's contents.
+ *
+ * The contents are either owned and freed with delete[], or point into
+ * memory kept alive by owner, such as a mapped archive.
  */
 struct FileContentsInfo {
     char* data;
     size_t length;
+    std::shared_ptr<void> owner;
 
     FileContentsInfo(char* mem, size_t len) : data(mem), length(len) {
     }
 
+    FileContentsInfo(char* mem, size_t len, std::shared_ptr<void> keepAlive)
+        : data(mem), length(len), owner(std::move(keepAlive)) {
+    }
+
     ~FileContentsInfo() {
-        delete[] data;
+        if (!owner) {
+            delete[] data;
+        }
     }
 };
 
@@ -1,25 +1,59 @@
 #include <algorithm>
 #include <boost/range/iterator_range.hpp>
+#include <cstring>
 #include <fstream>
 #include <loaders/LoaderIMG.hpp>
 #include <platform/FileIndex.hpp>
+#include <rw/defines.hpp>
 
 using namespace boost::filesystem;
 
+constexpr uint32_t FileIndex::kLooseFile;
+
+namespace {
+/// Files separated by up to this many sectors are read together, reading
+/// the gap is cheaper than seeking over it.
+constexpr uint32_t kMaxReadGap = 16;
+/// Upper limit on the sectors covered by a single read
+constexpr uint32_t kMaxReadLength = 4096;
+/// Stride for touching the pages of a mapped read
+constexpr size_t kPageSize = 4096;
+}
+
 void FileIndex::indexGameDirectory(const fs::path& base_path) {
     gamedatapath_ = base_path;
 
+    auto prefix = base_path.string().size();
+
     for (const path& entry : boost::make_iterator_range(
              recursive_directory_iterator(base_path), {})) {
         if (is_regular_file(entry)) {
-            std::string name = entry.string();
-            std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+            // Key by the path relative to the game directory
+            const std::string& name = entry.string();
+            auto relative = prefix;
+            while (relative < name.size() &&
+                   (name[relative] == '/' || name[relative] == '\\')) {
+                relative++;
+            }
 
-            filesystemfiles_[name] = entry;
+            filesystemfiles_.insert(name.data() + relative,
+                                    name.size() - relative, paths_.size());
+            paths_.push_back(entry);
         }
     }
 }
 
+const fs::path& FileIndex::findFilePath(const std::string& path) const {
+    static const fs::path kNotFound;
+
+    auto index = filesystemfiles_.find(path);
+    if (index == nullptr) {
+        return kNotFound;
+    }
+
+    return paths_[*index];
+}
+
 FileHandle FileIndex::openFilePath(const std::string& file_path) {
     auto datapath = findFilePath(file_path);
     std::ifstream dfile(datapath.string(),
@@ -39,14 +73,12 @@ FileHandle FileIndex::openFilePath(const std::string& file_path) {
 void FileIndex::indexTree(const std::string& root) {
     for (const path& entry :
          boost::make_iterator_range(recursive_directory_iterator(root), {})) {
-        std::string directory = entry.parent_path().string();
-        std::string realName = entry.filename().string();
-        std::string lowerName = realName;
-        std::transform(lowerName.begin(), lowerName.end(), lowerName.begin(),
-                       ::tolower);
-
         if (is_regular_file(entry)) {
-            files[lowerName] = {lowerName, realName, directory, ""};
+            std::string name = entry.filename().string();
+            IndexData data{kLooseFile, static_cast<uint32_t>(paths_.size()),
+                           0};
+            files.insert(name, data);
+            paths_.push_back(entry);
         }
     }
 }
@@ -64,65 +96,175 @@ void FileIndex::indexArchive(const std::string& archive) {
                                  archive_full_path.string());
     }
 
-    std::string lowerName;
+    // Assets will be read from the archive directly if it can't be mapped
+    img.map();
+
+    auto archiveID = static_cast<uint32_t>(archives.size());
+
     for (size_t i = 0; i < img.getAssetCount(); ++i) {
         auto& asset = img.getAssetInfoByIndex(i);
 
         if (asset.size == 0) continue;
 
-        lowerName = asset.name;
-        std::transform(lowerName.begin(), lowerName.end(), lowerName.begin(),
-                       ::tolower);
-
-        files[lowerName] = {lowerName, asset.name, directory.string(),
-                            archive_basename.string()};
+        IndexData data{archiveID, asset.offset, asset.size};
+        files.insert(asset.name, strnlen(asset.name, sizeof(asset.name)),
+                     data);
     }
+
+    archives.push_back(std::move(img));
 }
 
 FileHandle FileIndex::openFile(const std::string& filename) {
-    auto iterator = files.find(filename);
-    if (iterator == files.end()) {
+    auto f = files.find(filename);
+    if (f == nullptr) {
         return nullptr;
     }
 
-    IndexData& f = iterator->second;
-    bool isArchive = !f.archive.empty();
+    if (f->archive != kLooseFile) {
+        LoaderIMGFile file;
+        file.offset = f->offset;
+        file.size = f->size;
+        std::strncpy(file.name, filename.c_str(), sizeof(file.name) - 1);
+        file.name[sizeof(file.name) - 1] = '\0';
+
+        return archives[f->archive].openAsset(file);
+    }
+
+    auto& fsName = paths_[f->offset];
 
-    auto fsName = f.directory + "/" + f.originalName;
+    std::ifstream dfile(fsName.string(), std::ios_base::binary);
+    if (!dfile.is_open()) {
+        throw std::runtime_error("Unable to open file: " + fsName.string());
+    }
 
-    char* data = nullptr;
-    size_t length = 0;
+    dfile.seekg(0, std::ios_base::end);
+    size_t length = dfile.tellg();
+    dfile.seekg(0);
+    char* data = new char[length];
+    dfile.read(data, length);
 
-    if (isArchive) {
-        fsName = f.directory + "/" + f.archive;
+    return FileHandle(new FileContentsInfo{data, length});
+}
 
-        LoaderIMG img;
+std::vector<FileHandle> FileIndex::openFiles(
+    const std::vector<std::string>& filenames) {
+    std::vector<FileHandle> handles(filenames.size());
 
-        if (!img.load(fsName)) {
-            throw std::runtime_error("Failed to load IMG archive: " + fsName);
+    struct Request {
+        const IndexData* file;
+        size_t index;
+    };
+    std::vector<Request> requests;
+    requests.reserve(filenames.size());
+
+    for (size_t i = 0; i < filenames.size(); ++i) {
+        auto f = files.find(filenames[i]);
+        if (f == nullptr) {
+            continue;
+        }
+        if (f->archive == kLooseFile) {
+            handles[i] = openFile(filenames[i]);
+        } else {
+            requests.push_back({f, i});
         }
+    }
 
-        LoaderIMGFile file;
-        if (img.findAssetInfo(f.originalName, file)) {
-            length = file.size * 2048;
-            data = img.loadToMemory(f.originalName);
+    std::sort(requests.begin(), requests.end(),
+              [](const Request& a, const Request& b) {
+                  return a.file->archive != b.file->archive
+                             ? a.file->archive < b.file->archive
+                             : a.file->offset < b.file->offset;
+              });
+
+    for (size_t first = 0; first < requests.size();) {
+        // Extend the read over each following file that starts close enough
+        // to the end of the previous one.
+        auto start = requests[first].file;
+        uint32_t end = start->offset + start->size;
+        size_t last = first + 1;
+        for (; last < requests.size(); ++last) {
+            auto next = requests[last].file;
+            auto nextEnd = std::max(end, next->offset + next->size);
+            if (next->archive != start->archive ||
+                next->offset > end + kMaxReadGap ||
+                nextEnd - start->offset > kMaxReadLength) {
+                break;
+            }
+            end = nextEnd;
+        }
+
+        LoaderIMGFile read;
+        read.offset = start->offset;
+        read.size = end - start->offset;
+        std::strncpy(read.name, filenames[requests[first].index].c_str(),
+                     sizeof(read.name) - 1);
+        read.name[sizeof(read.name) - 1] = '\0';
+
+        auto contents = archives[start->archive].openAsset(read);
+
+        if (contents && contents->owner) {
+            // Fault the mapped pages in now, in order, instead of at random
+            // when the files are parsed.
+            char sum = 0;
+            for (size_t i = 0; i < contents->length; i += kPageSize) {
+                sum ^= contents->data[i];
+            }
+            volatile char sink = sum;
+            RW_UNUSED(sink);
         }
-    } else {
-        std::ifstream dfile(fsName.c_str(), std::ios_base::binary);
-        if (!dfile.is_open()) {
-            throw std::runtime_error("Unable to open file: " + fsName);
+
+        for (size_t i = first; contents && i < last; ++i) {
+            auto file = requests[i].file;
+            size_t offset = (file->offset - start->offset) * kIMGSectorSize;
+            if (offset >= contents->length) {
+                continue;
+            }
+            size_t length = std::min<size_t>(file->size * kIMGSectorSize,
+                                             contents->length - offset);
+            handles[requests[i].index] = std::make_shared<FileContentsInfo>(
+                contents->data + offset, length, contents);
         }
 
-        dfile.seekg(0, std::ios_base::end);
-        length = dfile.tellg();
-        dfile.seekg(0);
-        data = new char[length];
-        dfile.read(data, length);
+        first = last;
     }
 
-    if (data == nullptr) {
-        return nullptr;
+    return handles;
+}
+
+void FileIndex::queueFiles(WorkContext* context,
+                           std::vector<std::string> filenames,
+                           FileCallback callback, WorkJob::Priority priority) {
+    context->queueJob(new LoadFileBatchJob(context, this, std::move(filenames),
+                                           std::move(callback)),
+                      priority);
+}
+
+LoadFileBatchJob::LoadFileBatchJob(WorkContext* context, FileIndex* index,
+                                   std::vector<std::string> files,
+                                   FileIndex::FileCallback callback)
+    : WorkJob(context, Prefetch)
+    , fileIndex(index)
+    , _files(std::move(files))
+    , _callback(std::move(callback)) {
+}
+
+void LoadFileBatchJob::work() {
+    data = fileIndex->openFiles(_files);
+}
+
+void LoadFileBatchJob::complete() {
+    if (!_callback) {
+        return;
+    }
+    for (size_t i = 0; i < _files.size(); ++i) {
+        _callback(_files[i], data[i]);
     }
+}
 
-    return FileHandle(new FileContentsInfo{data, length});
+size_t LoadFileBatchJob::getCompleteCost() const {
+    size_t cost = 0;
+    for (auto& file : data) {
+        cost += file ? file->length : 0;
+    }
+    return cost;
 }
@@ -2,32 +2,30 @@
 #define RWENGINE_FILEINDEX_HPP
 #include "FileHandle.hpp"
 
+#include <job/WorkContext.hpp>
+#include <loaders/LoaderIMG.hpp>
+
+#include <rw/NameTable.hpp>
+
 #include <boost/filesystem.hpp>
-#include <boost/functional/hash.hpp>
-#include <map>
+#include <functional>
 #include <string>
-#include <unordered_map>
+#include <vector>
 
 namespace fs = boost::filesystem;
 
-namespace std {
-template <>
-struct hash<fs::path> {
-    size_t operator()(const fs::path& p) const {
-        return fs::hash_value(p);
-    }
-};
-}
-
 class FileIndex {
 private:
+    fs::path gamedatapath_;
+
     /**
-     * Mapping type (lower case name) => (on disk name)
+     * Mapping of (case insensitive path relative to the game directory) =>
+     * (index of the path as it is on disk in paths_)
      */
-    using FileSystemMap = std::unordered_map<fs::path, fs::path>;
+    RW::NameTable<uint32_t> filesystemfiles_;
 
-    fs::path gamedatapath_;
-    FileSystemMap filesystemfiles_;
+    /// Disk paths of indexed files
+    std::vector<fs::path> paths_;
 
 public:
     /**
@@ -42,20 +40,11 @@ public:
 
     /**
      * @brief findFilePath finds disk path for a game data file
-     * @param path
-     * @return The file path as it exists on disk
+     * @param path Path relative to the game directory, in any case, with
+     * either forward or back slashes.
+     * @return The file path as it exists on disk, or an empty path
      */
-    fs::path findFilePath(std::string path) {
-        auto backslash = std::string::npos;
-        while ((backslash = path.find("\\")) != std::string::npos) {
-            path.replace(backslash, 1, "/");
-        }
-        auto realpath = gamedatapath_ / path;
-        std::string name = realpath.string();
-        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
-
-        return filesystemfiles_[name];
-    }
+    const fs::path& findFilePath(const std::string& path) const;
 
     /**
      * @brief openFilePath opens a file on the disk
@@ -64,15 +53,17 @@ public:
      */
     FileHandle openFilePath(const std::string& file_path);
 
+    /// Archive value of IndexData for files that aren't in an archive
+    static constexpr uint32_t kLooseFile = ~0u;
+
     struct IndexData {
-        /// Lowercase identifying filename
-        std::string filename;
-        /// Original filename
-        std::string originalName;
-        /// Containing directory
-        std::string directory;
-        /// The archive filename (if applicable)
-        std::string archive;
+        /// Index of the containing archive, or kLooseFile
+        uint32_t archive;
+        /// Offset in sectors within the archive, or the index of the file's
+        /// disk path for loose files
+        uint32_t offset;
+        /// Size in sectors within the archive
+        uint32_t size;
     };
 
     /**
@@ -83,18 +74,69 @@ public:
 
     /**
      * Adds the files contained within the given Archive file to the
-     * file index.
+     * file index. The archive is kept open and mapped into memory for the
+     * lifetime of the index.
      */
     void indexArchive(const std::string& archive);
 
+    /**
+     * Returns the index entry for a file, looked up without regard to case.
+     * Returns nullptr if the file isn't in the index.
+     */
+    const IndexData* findFile(const std::string& filename) const {
+        return files.find(filename);
+    }
+
     /**
      * Returns a FileHandle for the file if it can be found in the
      * file index, otherwise an empty FileHandle is returned.
      */
     FileHandle openFile(const std::string& filename);
 
+    /**
+     * Returns FileHandles for a batch of files, in the same order as
+     * filenames. Files that can't be found have an empty FileHandle.
+     *
+     * Archived files are read in archive order, and files that are close
+     * together are read with a single sequential read.
+     */
+    std::vector<FileHandle> openFiles(
+        const std::vector<std::string>& filenames);
+
+    using FileCallback = std::function<void(const std::string&, FileHandle)>;
+
+    /**
+     * Reads a batch of files in the background with openFiles. The callback
+     * is called for each file when the WorkContext is updated.
+     */
+    void queueFiles(WorkContext* context, std::vector<std::string> filenames,
+                    FileCallback callback,
+                    WorkJob::Priority priority = WorkJob::Prefetch);
+
+private:
+    RW::NameTable<IndexData> files;
+
+    /// Indexed archives, by IndexData::archive
+    std::vector<LoaderIMG> archives;
+};
+
+class LoadFileBatchJob : public WorkJob {
 private:
-    std::map<std::string, IndexData> files;
+    FileIndex* fileIndex;
+    std::vector<std::string> _files;
+    FileIndex::FileCallback _callback;
+    std::vector<FileHandle> data;
+
+public:
+    LoadFileBatchJob(WorkContext* context, FileIndex* index,
+                     std::vector<std::string> files,
+                     FileIndex::FileCallback callback);
+
+    void work();
+
+    void complete();
+
+    size_t getCompleteCost() const;
 };
 
 #endif
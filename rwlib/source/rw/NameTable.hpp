@@ -0,0 +1,185 @@
+#pragma once
+#ifndef _RWNAMETABLE_HPP_
+#define _RWNAMETABLE_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace RW {
+
+/**
+ * Normalises a character for name comparison: ASCII is lower cased and
+ * back slashes become forward slashes, so that DOS style paths match.
+ */
+inline char normaliseNameChar(char c) {
+    if (c >= 'A' && c <= 'Z') {
+        return c - 'A' + 'a';
+    }
+    return c == '\\' ? '/' : c;
+}
+
+/**
+ * Case insensitive FNV-1a hash of a name, never returns 0
+ */
+inline uint64_t hashName(const char* name, size_t length) {
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= static_cast<unsigned char>(normaliseNameChar(name[i]));
+        hash *= 1099511628211ull;
+    }
+    return hash == 0 ? 1 : hash;
+}
+
+inline uint64_t hashName(const std::string& name) {
+    return hashName(name.data(), name.size());
+}
+
+/**
+ * Case insensitive name comparison, matching hashName
+ */
+inline bool namesEqual(const char* a, size_t alength, const char* b,
+                       size_t blength) {
+    if (alength != blength) {
+        return false;
+    }
+    for (size_t i = 0; i < alength; ++i) {
+        if (normaliseNameChar(a[i]) != normaliseNameChar(b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Flat open addressing hash table keyed by case insensitive names
+ *
+ * Names are copied into a single pool when inserted, so lookups don't need
+ * to allocate and entries stay small. Inserting an existing name replaces
+ * its value.
+ */
+template <class T>
+class NameTable {
+    struct Slot {
+        /// Hash of the name, 0 for an empty slot
+        uint64_t hash;
+        /// Offset of the name in the pool
+        uint32_t name;
+        uint32_t length;
+        T value;
+    };
+
+    std::vector<Slot> slots;
+    std::vector<char> names;
+    size_t count;
+
+    size_t findSlot(uint64_t hash, const char* name, size_t length) const {
+        size_t mask = slots.size() - 1;
+        for (size_t i = hash & mask;; i = (i + 1) & mask) {
+            const auto& slot = slots[i];
+            if (slot.hash == 0 ||
+                (slot.hash == hash &&
+                 namesEqual(&names[slot.name], slot.length, name, length))) {
+                return i;
+            }
+        }
+    }
+
+    void grow() {
+        std::vector<Slot> old(std::max<size_t>(16, slots.size() * 2));
+        old.swap(slots);
+        for (auto& slot : old) {
+            if (slot.hash == 0) {
+                continue;
+            }
+            size_t mask = slots.size() - 1;
+            size_t i = slot.hash & mask;
+            while (slots[i].hash != 0) {
+                i = (i + 1) & mask;
+            }
+            slots[i] = std::move(slot);
+        }
+    }
+
+public:
+    NameTable() : count(0) {
+    }
+
+    /**
+     * @return The value for name, or nullptr if it's not in the table
+     */
+    const T* find(const char* name, size_t length) const {
+        if (count == 0) {
+            return nullptr;
+        }
+        auto& slot = slots[findSlot(hashName(name, length), name, length)];
+        return slot.hash == 0 ? nullptr : &slot.value;
+    }
+
+    T* find(const char* name, size_t length) {
+        return const_cast<T*>(
+            static_cast<const NameTable*>(this)->find(name, length));
+    }
+
+    const T* find(const std::string& name) const {
+        return find(name.data(), name.size());
+    }
+
+    T* find(const std::string& name) {
+        return find(name.data(), name.size());
+    }
+
+    /**
+     * Inserts value for name, replacing any existing value
+     */
+    T& insert(const char* name, size_t length, const T& value) {
+        // Keep the load factor at or below one half
+        if ((count + 1) * 2 > slots.size()) {
+            grow();
+        }
+
+        auto hash = hashName(name, length);
+        auto& slot = slots[findSlot(hash, name, length)];
+        if (slot.hash == 0) {
+            slot.hash = hash;
+            slot.name = static_cast<uint32_t>(names.size());
+            slot.length = static_cast<uint32_t>(length);
+            names.insert(names.end(), name, name + length);
+            names.push_back('\0');
+            ++count;
+        }
+        slot.value = value;
+        return slot.value;
+    }
+
+    T& insert(const std::string& name, const T& value) {
+        return insert(name.data(), name.size(), value);
+    }
+
+    /**
+     * Calls f(name, value) for each entry, in no particular order
+     */
+    template <class F>
+    void forEach(F f) const {
+        for (auto& slot : slots) {
+            if (slot.hash != 0) {
+                f(&names[slot.name], slot.value);
+            }
+        }
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    void clear() {
+        slots.clear();
+        names.clear();
+        count = 0;
+    }
+};
+}
+
+#endif
@@ -1,9 +1,35 @@
 #include <boost/test/unit_test.hpp>
+#include <fstream>
 #include <platform/FileIndex.hpp>
 #include <test_globals.hpp>
 
 BOOST_AUTO_TEST_SUITE(FileIndexTests)
 
+BOOST_AUTO_TEST_CASE(test_case_insensitive) {
+    auto root = fs::temp_directory_path() / fs::unique_path();
+    fs::create_directories(root / "Data" / "Maps");
+    std::ofstream(fs::path(root / "Data" / "Maps" / "Test.IPL").string())
+        << "inst";
+
+    FileIndex index;
+    index.indexGameDirectory(root);
+    index.indexTree(root.string());
+
+    auto truepath = index.findFilePath("DATA\\maps\\test.ipl");
+    BOOST_CHECK_EQUAL(truepath.native(),
+                      (root / "Data" / "Maps" / "Test.IPL").native());
+    BOOST_CHECK(index.findFilePath("data/maps/missing.ipl").empty());
+
+    BOOST_CHECK(index.findFile("TEST.ipl") != nullptr);
+    BOOST_CHECK(index.findFile("test") == nullptr);
+
+    auto handle = index.openFile("test.ipl");
+    BOOST_REQUIRE(handle != nullptr);
+    BOOST_CHECK_EQUAL(std::string(handle->data, handle->length), "inst");
+
+    fs::remove_all(root);
+}
+
 #if RW_TEST_WITH_DATA
 BOOST_AUTO_TEST_CASE(test_directory_paths) {
     FileIndex index;
@@ -4,6 +4,43 @@
 
 BOOST_AUTO_TEST_SUITE(GameDataTests)
 
+BOOST_AUTO_TEST_CASE(test_name_and_lod) {
+    int lod = 0;
+    BOOST_CHECK_EQUAL(GameData::splitNameAndLod("bridge_l2", lod), 6u);
+    BOOST_CHECK_EQUAL(lod, 2);
+
+    lod = 0;
+    BOOST_CHECK_EQUAL(GameData::splitNameAndLod("rd_corner1", lod), 10u);
+    BOOST_CHECK_EQUAL(lod, 0);
+
+    std::string name = "bridge_l1";
+    GameData::getNameAndLod(name, lod);
+    BOOST_CHECK_EQUAL(name, "bridge");
+    BOOST_CHECK_EQUAL(lod, 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_atomic_lod_range) {
+    ModelFrame frame(0, nullptr, glm::mat3(), glm::vec3());
+    SimpleModelInfo info;
+
+    int lod = 0;
+    GameData::splitNameAndLod("bridge_l3", lod);
+    BOOST_CHECK_EQUAL(lod, 3);
+    info.setAtomic(nullptr, lod, &frame);
+    for (int i = 0; i < 3; ++i) {
+        BOOST_CHECK(info.getAtomic(i) == nullptr);
+    }
+
+    GameData::splitNameAndLod("bridge_l-1", lod);
+    info.setAtomic(nullptr, lod, &frame);
+    for (int i = 0; i < 3; ++i) {
+        BOOST_CHECK(info.getAtomic(i) == nullptr);
+    }
+
+    info.setAtomic(nullptr, 2, &frame);
+    BOOST_CHECK(info.getAtomic(2) == &frame);
+}
+
 #if RW_TEST_WITH_DATA
 BOOST_AUTO_TEST_CASE(test_object_data) {
     GameData gd(&Global::get().log, &Global::get().work, Global::getGamePath());
@@ -24,6 +61,9 @@ BOOST_AUTO_TEST_CASE(test_object_data) {
         BOOST_CHECK_EQUAL(def->getLodDistance(0), 220);
         BOOST_CHECK_EQUAL(def->flags, 0);
     }
+
+    BOOST_CHECK_EQUAL(gd.findModelObject("RD_CORNER1"), 1100);
+    BOOST_CHECK_EQUAL(gd.findModelObject("not_a_model"), uint16_t(-1));
 }
 #endif
 
@@ -1,9 +1,13 @@
 #include <boost/test/unit_test.hpp>
+#include <dynamics/CollisionInstance.hpp>
 #include <engine/GameData.hpp>
 #include <engine/GameWorld.hpp>
 #include <objects/InstanceObject.hpp>
 #include <test_globals.hpp>
 
+#include <algorithm>
+#include <thread>
+
 BOOST_AUTO_TEST_SUITE(GameWorldTests)
 
 #if RW_TEST_WITH_DATA
@@ -16,6 +20,17 @@ BOOST_AUTO_TEST_CASE(test_gameobject_id) {
     BOOST_CHECK_NE(object1->getGameObjectID(), object2->getGameObjectID());
 }
 
+BOOST_AUTO_TEST_CASE(test_shared_collision) {
+    GameWorld gw(&Global::get().log, &Global::get().work, Global::get().d);
+
+    auto object1 = gw.createInstance(1337, glm::vec3(100.f, 0.f, 0.f));
+    auto object2 = gw.createInstance(1337, glm::vec3(100.f, 0.f, 100.f));
+
+    BOOST_REQUIRE(object1->body && object2->body);
+    BOOST_CHECK_EQUAL(object1->body->getBulletBody()->getCollisionShape(),
+                      object2->body->getBulletBody()->getCollisionShape());
+}
+
 BOOST_AUTO_TEST_CASE(test_offsetgametime) {
     GameWorld gw(&Global::get().log, &Global::get().work, Global::get().d);
     gw.state = new GameState();
@@ -67,6 +82,51 @@ BOOST_AUTO_TEST_CASE(test_offsetgametime) {
     BOOST_CHECK_EQUAL(9, gw.getHour());
     BOOST_CHECK_EQUAL(25, gw.getMinute());
 }
+
+BOOST_AUTO_TEST_CASE(test_streaming) {
+    auto data = Global::get().d;
+    auto& work = Global::get().work;
+
+    // A model nothing has loaded yet
+    SimpleModelInfo* info = nullptr;
+    for (auto& model : data->modelinfo) {
+        auto simple = static_cast<SimpleModelInfo*>(model.second.get());
+        std::string file = simple->name + ".dff";
+        std::transform(file.begin(), file.end(), file.begin(), ::tolower);
+        if (simple->type() == ModelDataType::SimpleInfo &&
+            !simple->isLoaded() && simple->getReferenceCount() == 0 &&
+            data->index.openFile(file)) {
+            info = simple;
+            break;
+        }
+    }
+    BOOST_REQUIRE(info);
+
+    // With no budget, models are evicted as soon as they aren't needed
+    data->streaming = std::make_unique<StreamingManager>(data, &work, 0);
+    {
+        GameWorld gw(&Global::get().log, &work, data);
+        auto object = gw.createInstance(info->id(), glm::vec3(0.f));
+        BOOST_CHECK(!object->getModel());
+
+        data->streaming->update(glm::vec3(0.f));
+        while (data->streaming->getLoadingCount() > 0) {
+            work.update();
+            std::this_thread::yield();
+        }
+        BOOST_CHECK(info->isLoaded());
+        BOOST_CHECK_EQUAL(object->getModel(), info->getModel());
+
+        data->streaming->update(glm::vec3(0.f));
+        BOOST_CHECK(info->isLoaded());
+
+        data->streaming->update(glm::vec3(100000.f, 0.f, 0.f));
+        BOOST_CHECK(!info->isLoaded());
+        BOOST_CHECK(!object->getModel());
+        BOOST_CHECK_EQUAL(data->streaming->getEvictedCount(), 1u);
+    }
+    data->streaming.reset();
+}
 #endif
 
 BOOST_AUTO_TEST_SUITE_END()
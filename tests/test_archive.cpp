@@ -1,9 +1,116 @@
+#include <boost/filesystem.hpp>
 #include <boost/test/unit_test.hpp>
+#include <cstring>
+#include <fstream>
 #include <loaders/LoaderIMG.hpp>
+#include <platform/FileIndex.hpp>
 #include "test_globals.hpp"
 
+namespace {
+/**
+ * Writes an archive containing two assets, filled with 'a' and 'b'
+ */
+std::string writeTestArchive() {
+    auto dir = boost::filesystem::temp_directory_path() /
+               boost::filesystem::unique_path();
+    boost::filesystem::create_directories(dir);
+    auto base = (dir / "test").string();
+
+    LoaderIMGFile files[2] = {{0, 1, "a.dff"}, {1, 2, "B.TXD"}};
+    std::ofstream dirfile(base + ".dir", std::ios_base::binary);
+    dirfile.write(reinterpret_cast<char*>(files), sizeof(files));
+
+    std::ofstream imgfile(base + ".img", std::ios_base::binary);
+    imgfile << std::string(2048, 'a') << std::string(2 * 2048, 'b');
+
+    return base + ".img";
+}
+}
+
 BOOST_AUTO_TEST_SUITE(ArchiveTests)
 
+BOOST_AUTO_TEST_CASE(test_mapped_archive) {
+    auto path = writeTestArchive();
+
+    LoaderIMG archive;
+    BOOST_REQUIRE(archive.load(path));
+    BOOST_REQUIRE_EQUAL(archive.getAssetCount(), 2u);
+    BOOST_CHECK(!archive.isMapped());
+
+    LoaderIMGFile f;
+    BOOST_REQUIRE(archive.findAssetInfo("b.txd", f));
+
+    auto read = archive.openAsset(f);
+    BOOST_REQUIRE(read != nullptr);
+    BOOST_CHECK_EQUAL(read->length, 2 * 2048u);
+
+    BOOST_REQUIRE(archive.map());
+    BOOST_CHECK(archive.isMapped());
+
+    auto mapped = archive.openAsset(f);
+    BOOST_REQUIRE(mapped != nullptr);
+    BOOST_CHECK(mapped->owner != nullptr);
+    BOOST_CHECK_EQUAL(mapped->length, read->length);
+    BOOST_CHECK(std::memcmp(mapped->data, read->data, read->length) == 0);
+
+    boost::filesystem::remove_all(boost::filesystem::path(path).parent_path());
+}
+
+BOOST_AUTO_TEST_CASE(test_batch_archive) {
+    auto path = writeTestArchive();
+
+    FileIndex index;
+    index.indexArchive(path);
+
+    auto handles = index.openFiles({"b.txd", "missing.dff", "a.dff"});
+    BOOST_REQUIRE_EQUAL(handles.size(), 3u);
+    BOOST_REQUIRE(handles[0] != nullptr);
+    BOOST_CHECK(handles[1] == nullptr);
+    BOOST_REQUIRE(handles[2] != nullptr);
+
+    BOOST_CHECK_EQUAL(handles[0]->length, 2 * 2048u);
+    BOOST_CHECK_EQUAL(handles[0]->data[0], 'b');
+    BOOST_CHECK_EQUAL(handles[2]->length, 2048u);
+    BOOST_CHECK_EQUAL(handles[2]->data[0], 'a');
+
+    // Neighbouring files are read together
+    BOOST_CHECK(handles[0]->owner == handles[2]->owner);
+
+    WorkContext context(1);
+    std::vector<std::string> names;
+    index.queueFiles(&context, {"a.dff", "b.txd"},
+                     [&](const std::string& name, FileHandle file) {
+                         if (file) names.push_back(name);
+                     });
+    while (!context.isEmpty()) {
+        context.update();
+    }
+    BOOST_CHECK_EQUAL(names.size(), 2u);
+
+    boost::filesystem::remove_all(boost::filesystem::path(path).parent_path());
+}
+
+BOOST_AUTO_TEST_CASE(test_index_archive) {
+    auto path = writeTestArchive();
+
+    FileHandle handle;
+    {
+        FileIndex index;
+        index.indexArchive(path);
+
+        handle = index.openFile("a.dff");
+        BOOST_REQUIRE(handle != nullptr);
+        BOOST_CHECK(index.openFile("c.dff") == nullptr);
+    }
+
+    // The handle keeps the mapping alive after the index is gone
+    BOOST_CHECK_EQUAL(handle->length, 2048u);
+    BOOST_CHECK_EQUAL(handle->data[0], 'a');
+    BOOST_CHECK_EQUAL(handle->data[2047], 'a');
+
+    boost::filesystem::remove_all(boost::filesystem::path(path).parent_path());
+}
+
 #if RW_TEST_WITH_DATA
 BOOST_AUTO_TEST_CASE(test_open_archive) {
     LoaderIMG archive;
@@ -1,5 +1,21 @@
 #include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <cmath>
+#include <engine/GameWorld.hpp>
+#include <gl/TextureArrays.hpp>
+#include <numeric>
+#include <objects/InstanceObject.hpp>
+#include <random>
 #include <render/GameRenderer.hpp>
+#include <render/GameShaders.hpp>
+#include <render/InstanceRenderRecord.hpp>
+#include <render/ObjectRenderer.hpp>
+#include <render/OcclusionBuffer.hpp>
+#include <render/OpenGLRenderer.hpp>
+#include <render/RenderSort.hpp>
+#include <render/StaticInstanceTree.hpp>
+#include <render/StaticRenderCache.hpp>
+#include <render/UniformRing.hpp>
 #include "test_globals.hpp"
 
 BOOST_AUTO_TEST_SUITE(RendererTests)
@@ -24,4 +40,491 @@ BOOST_AUTO_TEST_CASE(frustum_test_visible) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(test_render_sort) {
+    {
+        std::mt19937 random(42);
+        std::vector<RenderSorter::Entry> entries(1000), scratch;
+        for (uint32_t i = 0; i < entries.size(); ++i) {
+            // Few distinct keys, so that stability is tested
+            entries[i] = {RenderKey(random() % 64) << 40 | (random() % 4),
+                          i};
+        }
+
+        auto expected = entries;
+        std::stable_sort(expected.begin(), expected.end(),
+                         [](const RenderSorter::Entry& a,
+                            const RenderSorter::Entry& b) {
+                             return a.key < b.key;
+                         });
+
+        RenderSorter::sortEntries(entries, scratch);
+
+        BOOST_REQUIRE_EQUAL(entries.size(), expected.size());
+        for (size_t i = 0; i < entries.size(); ++i) {
+            BOOST_CHECK_EQUAL(entries[i].key, expected[i].key);
+            BOOST_CHECK_EQUAL(entries[i].index, expected[i].index);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_render_sort_merge) {
+    {
+        std::mt19937 random(3);
+        RenderList list;
+        for (int i = 0; i < 500; ++i) {
+            list.addInstruction(RenderKey(random() % 32) << 20, 0, nullptr,
+                                Renderer::DrawParameters());
+        }
+
+        // Order the first part on its own, as if it were kept from before
+        RenderList prefix;
+        prefix.instructions.assign(list.instructions.begin(),
+                                   list.instructions.begin() + 200);
+        RenderSorter prefixSorter, sorter, expectedSorter;
+        auto sorted = prefixSorter.sort(prefix);
+
+        auto& merged = sorter.sort(list, sorted);
+        auto& expected = expectedSorter.sort(list);
+        BOOST_REQUIRE_EQUAL(merged.size(), expected.size());
+        for (size_t i = 0; i < merged.size(); ++i) {
+            BOOST_CHECK_EQUAL(merged[i], expected[i]);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_render_key_layout) {
+    {
+        RenderKeyLayout layout;
+        BOOST_CHECK(layout.isValid());
+
+        // Opaque draws are grouped by buffer, then texture, then depth
+        BOOST_CHECK_LT(layout.opaque(1, 9, 1.f), layout.opaque(2, 1, 0.f));
+        BOOST_CHECK_LT(layout.opaque(1, 1, 1.f), layout.opaque(1, 2, 0.f));
+        BOOST_CHECK_LT(layout.opaque(1, 1, 0.1f), layout.opaque(1, 1, 0.5f));
+
+        // Translucent draws come last, back to front
+        BOOST_CHECK_LT(layout.opaque(0xFFFF, 0xFFFF, 1.f),
+                       layout.translucent(0, 1.f));
+        BOOST_CHECK_LT(layout.translucent(9, 0.5f),
+                       layout.translucent(1, 0.1f));
+
+        // Depth outside of the view doesn't spill into other fields
+        BOOST_CHECK_EQUAL(layout.opaque(1, 1, 2.f), layout.opaque(1, 1, 1.f));
+        BOOST_CHECK_EQUAL(layout.opaque(1, 1, -1.f),
+                          layout.opaque(1, 1, 0.f));
+        BOOST_CHECK_EQUAL(layout.opaque(1, 1, NAN), layout.opaque(1, 1, 0.f));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(frustum_test_batched) {
+    {
+        ViewFrustum f(0.1f, 100.f, glm::half_pi<float>(), 1.f);
+        f.update(f.projection());
+
+        std::mt19937 random(7);
+        std::uniform_real_distribution<float> position(-120.f, 120.f);
+        SphereList spheres;
+        // An odd count exercises the scalar tail as well as the SIMD paths
+        for (int i = 0; i < 211; ++i) {
+            spheres.add({position(random), position(random), position(random)},
+                        (random() % 100) / 10.f);
+        }
+
+        std::vector<uint64_t> visible(ViewFrustum::getMaskSize(211));
+        f.intersects(spheres, visible.data());
+
+        for (size_t i = 0; i < spheres.size(); ++i) {
+            glm::vec3 center(spheres.x[i], spheres.y[i], spheres.z[i]);
+            BOOST_CHECK_EQUAL(ViewFrustum::isVisible(visible.data(), i),
+                              f.intersects(center, spheres.radius[i]));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_uniform_ring) {
+    {
+        // Uploads need the GL context
+        Global::get();
+
+        UniformRing ring(1024, 256);
+        const std::vector<char> data(96, 1);
+
+        bool wrapped = false;
+        GLintptr last = 0;
+        for (int i = 0; i < 64; ++i) {
+            auto offset = ring.upload(3, data.data(), data.size());
+            auto regionOffset = offset % ring.getRegionSize();
+
+            BOOST_CHECK_EQUAL(offset % ring.getAlignment(), 0);
+            BOOST_CHECK_LT(offset / ring.getRegionSize(),
+                           GLintptr(UniformRing::kRegions));
+            BOOST_CHECK_LE(regionOffset + GLintptr(data.size()),
+                           ring.getRegionSize());
+
+            wrapped = wrapped || offset < last;
+            last = offset;
+        }
+        BOOST_CHECK(wrapped);
+
+        // A new frame starts at the next region
+        ring.nextFrame();
+        auto offset = ring.upload(3, data.data(), data.size());
+        BOOST_CHECK_EQUAL(offset % ring.getRegionSize(), 0);
+        BOOST_CHECK_NE(offset / ring.getRegionSize(),
+                       last / ring.getRegionSize());
+
+        BOOST_CHECK_EQUAL(glGetError(), GLenum(GL_NO_ERROR));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_instanced_draws) {
+    {
+        // Draws need the GL context
+        Global::get();
+
+        OpenGLRenderer renderer;
+        auto program =
+            renderer.createShader(GameShaders::WorldObject::VertexShader,
+                                  GameShaders::WorldObject::FragmentShader);
+        renderer.setUniformTexture(program, "texture", 0);
+        renderer.setUniformTexture(program, "texArray",
+                                   Renderer::kTextureArrayUnit);
+        renderer.setProgramBlockBinding(program, "SceneData", 1);
+        renderer.setProgramBlockBinding(program, "ObjectData", 2);
+        renderer.setSceneParameters({});
+
+        // A triangle each way round, so draws can use different ranges
+        std::vector<VertexP3> vertices{
+            {{0.f, 0.f, 0.f}}, {{1.f, 0.f, 0.f}}, {{0.f, 1.f, 0.f}}};
+        const std::vector<GLuint> indices{0, 1, 2, 0, 2, 1};
+        GeometryBuffer gbuff(vertices);
+        DrawBuffer dbuff;
+        dbuff.setFaceType(GL_TRIANGLES);
+        dbuff.addGeometry(&gbuff);
+
+        GLuint ebo;
+        glGenBuffers(1, &ebo);
+        glBindVertexArray(dbuff.getVAOName());
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * indices.size(),
+                     indices.data(), GL_STATIC_DRAW);
+        glBindVertexArray(0);
+
+        GLuint textures[2];
+        glGenTextures(2, textures);
+
+        Renderer::DrawParameters dp;
+        dp.start = 0;
+        dp.count = 3;
+        dp.textures = {textures[0]};
+        auto retextured = dp;
+        retextured.textures = {textures[1]};
+        auto blended = dp;
+        blended.blend = true;
+        auto reversed = dp;
+        reversed.start = 3;
+
+        RenderList list;
+        auto add = [&](const Renderer::DrawParameters& p, int count) {
+            for (int i = 0; i < count; ++i) {
+                auto transform = list.addTransform(
+                    glm::translate(glm::mat4(1.f), glm::vec3(i, 0.f, 0.f)));
+                list.addInstruction(0, transform, &dbuff, p);
+            }
+        };
+        // Equal state is one draw, each difference starts another
+        add(dp, 3);
+        add(blended, 1);
+        add(dp, 1);
+        add(retextured, 1);
+        add(dp, 1);
+        add(reversed, 1);
+        // Too many for one draw
+        add(dp, OpenGLRenderer::kMaxInstances + 2);
+
+        RenderOrder order(list.size());
+        std::iota(order.begin(), order.end(), 0);
+
+        renderer.invalidate();
+        renderer.useProgram(program);
+        renderer.swap();
+        renderer.drawBatched(list, order);
+
+        BOOST_CHECK_EQUAL(renderer.getDrawCount(), 8);
+        BOOST_CHECK_EQUAL(renderer.getBufferCount(), 1);
+        BOOST_CHECK_EQUAL(renderer.getAvoidedBufferCount(), 7);
+        // textures[0], textures[1], then textures[0] again
+        BOOST_CHECK_EQUAL(renderer.getTextureCount(), 3);
+        BOOST_CHECK_EQUAL(glGetError(), GLenum(GL_NO_ERROR));
+
+        glDeleteTextures(2, textures);
+        glDeleteBuffers(1, &ebo);
+        BOOST_CHECK_EQUAL(glGetError(), GLenum(GL_NO_ERROR));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_texture_arrays) {
+    {
+        // Uploads need the GL context
+        Global::get();
+
+        // Room for two 4x4 layers in each array
+        TextureArrays arrays(4 * 4 * 4 * 2);
+        const TextureArrays::Sampling repeat{GL_LINEAR, GL_REPEAT, GL_REPEAT};
+        const TextureArrays::Sampling clamp{GL_LINEAR, GL_CLAMP_TO_EDGE,
+                                            GL_REPEAT};
+        BOOST_CHECK_EQUAL(arrays.getLayerCapacity({4, 4}), 2);
+
+        std::vector<uint32_t> pixels(4 * 4);
+        std::vector<TextureArrays::Layer> layers;
+        for (uint32_t i = 0; i < 3; ++i) {
+            std::fill(pixels.begin(), pixels.end(), 0xFF000000 | i);
+            layers.push_back(arrays.add({4, 4}, repeat, GL_RGBA,
+                                        GL_UNSIGNED_BYTE, pixels.data()));
+        }
+        auto clamped = arrays.add({4, 4}, clamp, GL_RGBA, GL_UNSIGNED_BYTE,
+                                  pixels.data());
+
+        // Textures sampled the same way share an array until it is full
+        BOOST_CHECK_NE(layers[0].texture, 0u);
+        BOOST_CHECK_EQUAL(layers[1].texture, layers[0].texture);
+        BOOST_CHECK_EQUAL(layers[0].layer, 0);
+        BOOST_CHECK_EQUAL(layers[1].layer, 1);
+        BOOST_CHECK_NE(layers[2].texture, layers[0].texture);
+        BOOST_CHECK_EQUAL(layers[2].layer, 0);
+        BOOST_CHECK_NE(clamped.texture, layers[0].texture);
+        BOOST_CHECK_NE(clamped.texture, layers[2].texture);
+        BOOST_CHECK_EQUAL(arrays.getArrayCount(), 3u);
+
+        // Textures that would be alone in an array aren't packed
+        auto large = arrays.add({8, 8}, repeat, GL_RGBA, GL_UNSIGNED_BYTE,
+                                nullptr);
+        BOOST_CHECK_EQUAL(large.texture, 0u);
+
+        BOOST_CHECK(arrays.generateMipmaps());
+        BOOST_CHECK(!arrays.generateMipmaps());
+
+        // Each layer holds the texture added to it
+        std::vector<uint32_t> texels(4 * 4 * 2);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, layers[0].texture);
+        glGetTexImage(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                      texels.data());
+        BOOST_CHECK_EQUAL(texels[0], 0xFF000000u);
+        BOOST_CHECK_EQUAL(texels[4 * 4], 0xFF000001u);
+
+        BOOST_CHECK_EQUAL(glGetError(), GLenum(GL_NO_ERROR));
+    }
+    {
+        // Room for eight 4x4 layers, allocated as they're needed
+        TextureArrays arrays(4 * 4 * 4 * 8);
+        const TextureArrays::Sampling repeat{GL_LINEAR, GL_REPEAT, GL_REPEAT};
+        const GLsizeiptr layerBytes = 4 * 4 * 4;
+
+        std::vector<uint32_t> pixels(4 * 4);
+        std::vector<TextureArrays::Layer> layers;
+        for (uint32_t i = 0; i < 5; ++i) {
+            std::fill(pixels.begin(), pixels.end(), 0xFF000000 | i);
+            layers.push_back(arrays.add({4, 4}, repeat, GL_RGBA,
+                                        GL_UNSIGNED_BYTE, pixels.data()));
+            auto allocated = i < TextureArrays::kInitialLayers ? 4 : 8;
+            BOOST_CHECK_EQUAL(arrays.getAllocatedBytes(),
+                              layerBytes * allocated);
+        }
+
+        // Growing keeps the array's name and the layers already added
+        for (uint32_t i = 0; i < 5; ++i) {
+            BOOST_CHECK_EQUAL(layers[i].texture, layers[0].texture);
+            BOOST_CHECK_EQUAL(layers[i].layer, GLint(i));
+        }
+        BOOST_CHECK_EQUAL(arrays.getArrayCount(), 1u);
+        BOOST_CHECK(arrays.generateMipmaps());
+
+        std::vector<uint32_t> texels(4 * 4 * 8);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, layers[0].texture);
+        glGetTexImage(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                      texels.data());
+        for (uint32_t i = 0; i < 5; ++i) {
+            BOOST_CHECK_EQUAL(texels[i * 4 * 4], 0xFF000000u | i);
+        }
+
+        BOOST_CHECK_EQUAL(glGetError(), GLenum(GL_NO_ERROR));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_occlusion_buffer) {
+    {
+        // Looking down -z at a wall 20 units wide, 20 units away
+        OcclusionBuffer buffer(64, 32);
+        buffer.clear(glm::perspective(1.5f, 2.f, 0.1f, 1000.f));
+        buffer.addBox(glm::translate(glm::mat4(1.f), {0.f, 0.f, -20.f}),
+                      {-10.f, -5.f, -1.f}, {10.f, 5.f, 1.f});
+        BOOST_CHECK_EQUAL(buffer.getTriangleCount(), 12u);
+
+        // Rows can be rasterized in separate bands
+        buffer.rasterize(0, 10);
+        buffer.rasterize(10, 32);
+        BOOST_CHECK_LT(buffer.getDepth(32, 16), 1.f);
+        BOOST_CHECK_GT(buffer.getDepth(0, 0), 1.f);
+
+        BOOST_CHECK(!buffer.isVisible(glm::vec3(0.f, 0.f, -40.f), 2.f));
+        BOOST_CHECK(buffer.isVisible(glm::vec3(0.f, 0.f, -10.f), 2.f));
+        BOOST_CHECK(buffer.isVisible(glm::vec3(40.f, 0.f, -40.f), 2.f));
+        // Larger than the wall, or poking out from behind it
+        BOOST_CHECK(buffer.isVisible(glm::vec3(0.f, 0.f, -40.f), 30.f));
+        BOOST_CHECK(buffer.isVisible(glm::vec3(19.f, 0.f, -40.f), 3.f));
+        // Crossing the near plane
+        BOOST_CHECK(buffer.isVisible(glm::vec3(0.f, 0.f, 0.f), 1.f));
+
+        // Boxes crossing the near plane are dropped
+        buffer.clear(glm::perspective(1.5f, 2.f, 0.1f, 1000.f));
+        buffer.addBox(glm::mat4(1.f), glm::vec3(-1.f), glm::vec3(1.f));
+        BOOST_CHECK_EQUAL(buffer.getTriangleCount(), 0u);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_instance_render_record) {
+    {
+        // A building 10 units across, drawn within 100 and its LOD
+        // within 500
+        Model model, lodModel;
+        for (auto m : {&model, &lodModel}) {
+            m->frames.push_back(
+                new ModelFrame(0, nullptr, glm::mat3(), {1.f, 2.f, 3.f}));
+            auto geometry = std::make_shared<Model::Geometry>();
+            geometry->geometryBounds.center = {0.f, 0.f, 0.f};
+            geometry->geometryBounds.radius = 10.f;
+            m->geometries.push_back(geometry);
+            m->recalculateMetrics();
+        }
+
+        SimpleModelInfo info, lodInfo;
+        info.setNumAtomics(1);
+        info.setLodDistance(0, 100.f);
+        info.timeOn = 20;
+        info.timeOff = 6;
+        lodInfo.setNumAtomics(1);
+        lodInfo.setLodDistance(0, 500.f);
+        lodInfo.LOD = true;
+
+        InstanceRenderRecord record;
+        record.build(&info, &model, &lodInfo, &lodModel);
+        BOOST_CHECK(record.isBuiltFor(&info, &model, &lodInfo, &lodModel));
+        BOOST_CHECK(!record.isBuiltFor(&info, &model, &lodInfo, nullptr));
+
+        BOOST_CHECK(record.isShownAt(23));
+        BOOST_CHECK(record.isShownAt(0));
+        BOOST_CHECK(!record.isShownAt(6));
+        BOOST_CHECK(!record.isShownAt(12));
+
+        auto select = [&](float distance) {
+            return record.select(distance * distance);
+        };
+
+        auto near = select(50.f);
+        BOOST_CHECK_EQUAL(near.draw, 0);
+        BOOST_CHECK_EQUAL(near.fading, -1);
+
+        // Just past the draw distance the LOD is drawn as the model fades
+        auto fading = select(135.f);
+        BOOST_CHECK_EQUAL(fading.draw, 1);
+        BOOST_CHECK_EQUAL(fading.fading, 0);
+        BOOST_CHECK_CLOSE(fading.opacity, 0.5f, 0.01f);
+
+        auto far = select(300.f);
+        BOOST_CHECK_EQUAL(far.draw, 1);
+        BOOST_CHECK_EQUAL(far.fading, -1);
+
+        auto none = select(600.f);
+        BOOST_CHECK_EQUAL(none.draw, -1);
+        BOOST_CHECK_EQUAL(none.fading, -1);
+
+        BOOST_CHECK_CLOSE(record.inverseFrames[0][3][2], -3.f, 0.01f);
+    }
+}
+
+#if RW_TEST_WITH_DATA
+BOOST_AUTO_TEST_CASE(test_static_instance_tree) {
+    {
+        GameWorld gw(&Global::get().log, &Global::get().work, Global::get().d);
+        ViewFrustum f(0.1f, 100.f, glm::half_pi<float>(), 1.f);
+        f.update(f.projection());
+
+        StaticInstanceTree tree;
+        std::vector<InstanceObject*> ahead, behind;
+        for (int i = 0; i < 40; ++i) {
+            float x = i - 20.f;
+            ahead.push_back(gw.createInstance(1337, {x, 0.f, -50.f}));
+            behind.push_back(gw.createInstance(1337, {x, 0.f, 50.f}));
+            tree.insert(ahead.back());
+            tree.insert(behind.back());
+        }
+        BOOST_CHECK_EQUAL(tree.size(), 80u);
+        BOOST_CHECK(StaticInstanceTree::contains(ahead[0]));
+
+        tree.remove(ahead[0]);
+        BOOST_CHECK(!StaticInstanceTree::contains(ahead[0]));
+
+        std::vector<GameObject*> visible;
+        tree.findVisible(f, visible);
+
+        BOOST_CHECK_EQUAL(visible.size(), ahead.size() - 1);
+        for (size_t i = 1; i < ahead.size(); ++i) {
+            BOOST_CHECK(std::find(visible.begin(), visible.end(), ahead[i]) !=
+                        visible.end());
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_static_render_cache) {
+    {
+        GameWorld gw(&Global::get().log, &Global::get().work, Global::get().d);
+        ViewCamera camera;
+        camera.frustum.update(camera.frustum.projection() * camera.getView());
+
+        std::vector<GameObject*> instances;
+        for (int i = 0; i < 5; ++i) {
+            instances.push_back(
+                gw.createInstance(1337, {40.f, i * 2.f - 4.f, 0.f}));
+        }
+
+        ObjectRenderer renderer(&gw, camera, 1.f, 0);
+        auto expectList = [&](const RenderList& list) {
+            RenderList expected;
+            for (auto instance : instances) {
+                renderer.buildRenderList(instance, expected);
+            }
+            BOOST_REQUIRE_EQUAL(list.size(), expected.size());
+            for (size_t i = 0; i < list.size(); ++i) {
+                BOOST_CHECK_EQUAL(list[i].sortKey, expected[i].sortKey);
+                BOOST_CHECK(list.getTransform(list[i]) ==
+                            expected.getTransform(expected[i]));
+            }
+        };
+
+        StaticRenderCache cache;
+        auto update = [&] {
+            cache.update(instances, camera, gw.getHour(), renderer, 0,
+                         Global::get().work);
+        };
+
+        update();
+        BOOST_CHECK_EQUAL(cache.getListedCount(), instances.size());
+        BOOST_CHECK(!cache.isOrderReused());
+        expectList(cache.getList());
+
+        // Nothing changed, whatever was kept is reused as it was
+        update();
+        BOOST_CHECK_EQUAL(cache.isOrderReused(), cache.getListedCount() == 0);
+        expectList(cache.getList());
+
+        // Kept instructions are given keys for where the camera moved to
+        camera.position.x = 1.f;
+        camera.frustum.update(camera.frustum.projection() * camera.getView());
+        update();
+        BOOST_CHECK(!cache.isOrderReused());
+        expectList(cache.getList());
+    }
+}
+#endif
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -46,4 +46,325 @@ BOOST_AUTO_TEST_CASE(test_interface) {
     }
 }
 
+class CountingJob : public WorkJob {
+public:
+    std::atomic<int> *_worked;
+    int *_completed;
+
+    CountingJob(WorkContext *context, std::atomic<int> *w, int *c)
+        : WorkJob(context), _worked(w), _completed(c) {
+    }
+
+    void work() {
+        (*_worked)++;
+    }
+
+    void complete() {
+        (*_completed)++;
+    }
+};
+
+BOOST_AUTO_TEST_CASE(test_pool) {
+    {
+        WorkContext context(4);
+
+        BOOST_CHECK_EQUAL(context.getWorkerCount(), 4u);
+
+        std::atomic<int> worked(0);
+        int completed = 0;
+
+        for (int i = 0; i < 1000; ++i) {
+            context.queueJob(new CountingJob(&context, &worked, &completed));
+        }
+
+        while (worked < 1000 || context.getCompleteCount() < 1000) {
+            std::this_thread::yield();
+        }
+
+        BOOST_CHECK(!context.isEmpty());
+
+        context.update();
+
+        BOOST_CHECK_EQUAL(completed, 1000);
+        BOOST_CHECK(context.isEmpty());
+    }
+}
+
+class OrderJob : public WorkJob {
+public:
+    std::vector<int> *_order;
+    std::mutex *_mutex;
+    int _id;
+
+    OrderJob(WorkContext *context, std::vector<int> *order, std::mutex *m,
+             int id)
+        : WorkJob(context), _order(order), _mutex(m), _id(id) {
+    }
+
+    void work() {
+        std::lock_guard<std::mutex> guard(*_mutex);
+        _order->push_back(_id);
+    }
+};
+
+class GateJob : public WorkJob {
+public:
+    std::atomic<bool> *_open;
+
+    GateJob(WorkContext *context, std::atomic<bool> *open)
+        : WorkJob(context, Critical), _open(open) {
+    }
+
+    void work() {
+        while (!*_open) {
+            std::this_thread::yield();
+        }
+    }
+};
+
+void waitForWork(WorkContext &context) {
+    while (!context.isEmpty()) {
+        context.update();
+        std::this_thread::yield();
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_priority) {
+    {
+        WorkContext context(1);
+
+        std::atomic<bool> open(false);
+        std::vector<int> order;
+        std::mutex m;
+
+        // Hold the only worker until every job has been queued
+        context.queueJob(new GateJob(&context, &open));
+        context.queueJob(new OrderJob(&context, &order, &m, 3),
+                         WorkJob::Idle);
+        context.queueJob(new OrderJob(&context, &order, &m, 2),
+                         WorkJob::Prefetch);
+        context.queueJob(new OrderJob(&context, &order, &m, 0),
+                         WorkJob::Critical);
+        context.queueJob(new OrderJob(&context, &order, &m, 1),
+                         WorkJob::Streaming);
+        open = true;
+
+        waitForWork(context);
+
+        BOOST_REQUIRE_EQUAL(order.size(), 4u);
+        for (int i = 0; i < 4; ++i) {
+            BOOST_CHECK_EQUAL(order[i], i);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_cancel) {
+    {
+        WorkContext context(1);
+
+        std::atomic<bool> open(false);
+        bool worked = false, completed = false;
+
+        auto token = CancelToken::create();
+        auto job = new TestJob(&context, &worked, &completed);
+        job->setCancelToken(token);
+
+        context.queueJob(new GateJob(&context, &open));
+        context.queueJob(job);
+        token->cancel();
+        open = true;
+
+        waitForWork(context);
+
+        BOOST_CHECK(!worked);
+        BOOST_CHECK(!completed);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_dependencies) {
+    {
+        WorkContext context(4);
+
+        std::vector<int> order;
+        std::mutex m;
+
+        auto first = new OrderJob(&context, &order, &m, 0);
+        first->then(new OrderJob(&context, &order, &m, 1))
+            ->then(new OrderJob(&context, &order, &m, 2));
+
+        context.queueJob(first);
+
+        waitForWork(context);
+
+        BOOST_REQUIRE_EQUAL(order.size(), 3u);
+        for (int i = 0; i < 3; ++i) {
+            BOOST_CHECK_EQUAL(order[i], i);
+        }
+    }
+    {
+        WorkContext context(1);
+
+        std::atomic<bool> open(false);
+        std::vector<int> order;
+        std::mutex m;
+
+        auto token = CancelToken::create();
+        auto first = new OrderJob(&context, &order, &m, 0);
+        first->setCancelToken(token);
+        first->then(new OrderJob(&context, &order, &m, 1));
+
+        context.queueJob(new GateJob(&context, &open));
+        context.queueJob(first);
+        token->cancel();
+        open = true;
+
+        waitForWork(context);
+
+        BOOST_CHECK(order.empty());
+    }
+    {
+        WorkContext context(4);
+
+        std::vector<int> order;
+        std::mutex m;
+
+        // Until it completes, a queued job can still take dependents
+        auto first = new OrderJob(&context, &order, &m, 0);
+        context.queueJob(first);
+        first->then(new OrderJob(&context, &order, &m, 1));
+        first->then(new OrderJob(&context, &order, &m, 2));
+
+        waitForWork(context);
+
+        BOOST_REQUIRE_EQUAL(order.size(), 3u);
+        BOOST_CHECK_EQUAL(order[0], 0);
+    }
+}
+
+class CostJob : public CountingJob {
+public:
+    CostJob(WorkContext *context, std::atomic<int> *w, int *c)
+        : CountingJob(context, w, c) {
+    }
+
+    size_t getCompleteCost() const {
+        return 1024;
+    }
+};
+
+BOOST_AUTO_TEST_CASE(test_budget) {
+    {
+        WorkContext context(2);
+
+        std::atomic<int> worked(0);
+        int completed = 0;
+
+        for (int i = 0; i < 4; ++i) {
+            context.queueJob(new CostJob(&context, &worked, &completed));
+        }
+
+        while (worked < 4 || context.getCompleteCount() < 4) {
+            std::this_thread::yield();
+        }
+
+        auto budget = std::chrono::steady_clock::duration::max();
+        BOOST_CHECK_EQUAL(context.update(budget, 2048), 2u);
+        BOOST_CHECK_EQUAL(completed, 2);
+        BOOST_CHECK_EQUAL(context.getPendingCount(), 2u);
+
+        // At least one job is always completed
+        BOOST_CHECK_EQUAL(context.update(std::chrono::milliseconds(0)), 1u);
+        BOOST_CHECK_EQUAL(completed, 3);
+
+        BOOST_CHECK_EQUAL(context.update(budget), 0u);
+        BOOST_CHECK_EQUAL(completed, 4);
+        BOOST_CHECK(context.isEmpty());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_parallel_for) {
+    {
+        WorkContext context(4);
+
+        std::vector<int> items(1000, 0);
+        std::vector<size_t> chunkStarts(8, ~size_t(0));
+
+        context.parallelFor(items.size(), 128,
+                            [&](size_t chunk, size_t begin, size_t end) {
+                                chunkStarts[chunk] = begin;
+                                for (size_t i = begin; i < end; ++i) {
+                                    items[i]++;
+                                }
+                            });
+
+        for (auto item : items) {
+            BOOST_REQUIRE_EQUAL(item, 1);
+        }
+        for (size_t c = 0; c < chunkStarts.size(); ++c) {
+            BOOST_CHECK_EQUAL(chunkStarts[c], c * 128);
+        }
+
+        // Helpers are cleaned up like any other job
+        while (!context.isEmpty()) {
+            context.update();
+            std::this_thread::yield();
+        }
+    }
+}
+
+class TrackedJob : public WorkJob {
+public:
+    std::atomic<int> *_alive;
+
+    TrackedJob(WorkContext *context, std::atomic<int> *alive)
+        : WorkJob(context), _alive(alive) {
+        (*_alive)++;
+    }
+
+    ~TrackedJob() {
+        (*_alive)--;
+    }
+
+    void work() {
+        volatile int sum = 0;
+        for (int i = 0; i < 2000; ++i) {
+            sum += i;
+        }
+    }
+};
+
+BOOST_AUTO_TEST_CASE(test_stop_busy) {
+    {
+        std::atomic<int> alive(0);
+
+        // Destroyed while workers are still running and stealing jobs
+        for (int round = 0; round < 20; ++round) {
+            WorkContext context(8);
+            for (int i = 0; i < 2000; ++i) {
+                auto job = new TrackedJob(&context, &alive);
+                if (i % 10 == 0) {
+                    job->then(new TrackedJob(&context, &alive));
+                }
+                context.queueJob(job);
+            }
+        }
+
+        // Jobs that never ran are deleted along with their dependents
+        BOOST_CHECK_EQUAL(alive, 0);
+    }
+    {
+        WorkContext context(2);
+        context.stop();
+
+        bool worked = false, completed = false;
+        context.queueJob(new TestJob(&context, &worked, &completed));
+        context.update();
+
+        // Jobs queued once stopped are discarded, not left waiting
+        BOOST_CHECK(!worked);
+        BOOST_CHECK(!completed);
+        BOOST_CHECK(context.isEmpty());
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()